@@ -0,0 +1,41 @@
+//  Author: Arjun Ramaswami
+
+#ifndef BUF_POOL_H
+#define BUF_POOL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "transpose_fpga.h"
+
+// Buffers of any kind recycled by their size and a key, e.g. a memory bank
+typedef struct buf_pool buf_pool_t;
+
+// Allocate a buffer of sz bytes for a key, NULL on failure
+typedef void* (*buf_create_fn)(size_t sz, uint64_t key);
+
+// Release a buffer created by the above
+typedef void (*buf_destroy_fn)(void *buf, size_t sz, uint64_t key);
+
+// Create a pool holding at most cap bytes in use and idle, 0 for no limit
+extern buf_pool_t* buf_pool_create(size_t cap, buf_create_fn create, buf_destroy_fn destroy);
+
+// Idle buffer of the same size and key or a new one, NULL beyond the cap.
+// created, if not NULL, is set to 1 for a new buffer
+extern void* buf_pool_acquire(buf_pool_t *pool, size_t sz, uint64_t key, int *created);
+
+// Return a buffer for reuse, -1 if not acquired from the pool
+extern int buf_pool_release(buf_pool_t *pool, void *buf);
+
+// Change the cap, releasing idle buffers beyond it
+extern void buf_pool_limit(buf_pool_t *pool, size_t cap);
+
+// Release every idle buffer
+extern void buf_pool_trim(buf_pool_t *pool);
+
+// Counters of the pool
+extern void buf_pool_stats(buf_pool_t *pool, fpga_pool_stats_t *stats);
+
+// Release the idle buffers and the pool, buffers in use are left to the caller
+extern void buf_pool_destroy(buf_pool_t *pool);
+
+#endif // BUF_POOL_H
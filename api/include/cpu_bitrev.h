@@ -0,0 +1,17 @@
+//  Author: Arjun Ramaswami
+
+#ifndef CPU_BITREV_H
+#define CPU_BITREV_H
+
+#include <stddef.h>
+#include "transpose_fpga.h"
+
+// In place bit reversal of every row of rows x N values: value p of word k,
+// a word being 2^logpoints values, moves to [rev(p)][k]
+void cpu_bitrev_rows(float2 *data, int N, size_t rows, int logpoints);
+
+// Out of place transpose of a batch of N x N matrices, bit reversing the
+// rows of the output in the same pass
+void cpu_transpose_bitrev(const float2 *inp, float2 *out, int N, int batch, int logpoints);
+
+#endif // CPU_BITREV_H
@@ -0,0 +1,27 @@
+//  Author: Arjun Ramaswami
+
+#ifndef CPU_POOL_H
+#define CPU_POOL_H
+
+#include "transpose_fpga.h"
+
+// Pool of worker threads pinned to cores that transpose batches on the CPU
+typedef struct cpu_pool cpu_pool_t;
+
+// Create a pool of nthreads workers, 0 uses every online core
+extern cpu_pool_t* cpu_pool_create(int nthreads);
+
+// Number of workers of the pool
+extern int cpu_pool_threads(cpu_pool_t *pool);
+
+// Touch the pages of a new buffer on the workers that write them in
+// cpu_pool_mTranspose
+extern void cpu_pool_first_touch(cpu_pool_t *pool, void *buf, size_t sz);
+
+// Batched transposition with the same semantics as mTranspose
+extern fpga_t cpu_pool_mTranspose(cpu_pool_t *pool, int N, float2 *inp, float2 *out, int batch);
+
+// Join the workers and release the pool
+extern void cpu_pool_destroy(cpu_pool_t *pool);
+
+#endif // CPU_POOL_H
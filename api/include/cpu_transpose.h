@@ -0,0 +1,22 @@
+//  Author: Arjun Ramaswami
+
+#ifndef CPU_TRANSPOSE_H
+#define CPU_TRANSPOSE_H
+
+#include <stddef.h>
+#include "transpose_fpga.h"
+
+// Transpose a rows x cols block of src into a cols x rows block of dst
+// ld_src and ld_dst are the row strides in elements
+void cpu_transpose_block(const float2 *src, size_t ld_src, float2 *dst, size_t ld_dst, size_t rows, size_t cols);
+
+// Out of place transpose of a batch of N x N matrices
+void cpu_transpose(const float2 *inp, float2 *out, int N, int batch);
+
+// In place transpose of a batch of N x N matrices
+void cpu_transpose_inplace(float2 *data, int N, int batch);
+
+// Name of the instruction set selected at runtime
+const char* cpu_transpose_isa();
+
+#endif // CPU_TRANSPOSE_H
@@ -5,16 +5,44 @@
 
 #include <stdbool.h>
 
-void get_input_data(float2 *transpose_data, float2 *cpu_transpose_data, unsigned N, unsigned iter, bool bitreverse);
+void get_input_data(float2 *transpose_data, float2 *cpu_transpose_data, unsigned N, unsigned iter, bool bitreverse, int logpoints);
 
 double getTimeinMilliSec();
 
 void cpu_mTranspose(float2 *verify_data, int N, unsigned batch);
 
-void verify_mTranspose(float2 *fpga_out, float2 *cpu_out, int N, int batch, bool bitreverse);
+int cpu_mTranspose_naive(float2 *verify_data, int N, unsigned batch);
 
-void print_config(int n, int batch, int use_svm, char *path, int isND);
+void cpu_bench_mTranspose(float2 *data, int N, int batch, int iter);
 
-void display_measures(double b_exec, double pcie_rd_t, double pcie_wr_t, int N, int batch);
+void cpu_bench_bitrev(const float2 *data, int N, int batch, int iter, int logpoints);
+
+void verify_mTranspose(float2 *fpga_out, float2 *cpu_out, int N, int batch, bool bitreverse, int logpoints);
+
+void print_config(int n, int batch, int use_svm, char *path, int isND, const char *backend);
+
+void display_measures(double b_exec, double pcie_rd_t, double pcie_wr_t, int N, int batch, size_t elem_sz);
+
+void display_latency(double call_t, double plan_t, int iter);
+
+void display_profile(const fpga_profile_t *prof);
+
+void display_async(double plan_t, double async_t, int iter, int N, int batch);
+
+void display_pool(const char *name, const fpga_pool_stats_t *stats);
+
+void display_file(const fpga_file_t *file, double total_t, int N);
+
+void display_coalesce(const fpga_coalesce_stats_t *stats, double single_t, double total_t, int N);
+
+void display_stream(double serial_t, double stream_t, int N, int batch, int chunk);
+
+void display_multi(const fpga_multi_t *multi, int N);
+
+void get_rect_data(float2 *inp, int rows, int cols, int batch);
+
+void verify_rect(float2 *inp, float2 *out, int rows, int cols, int batch);
+
+void display_tiling(double exec_t, int rows, int cols, int N, int batch, fpga_tiling_t *tiling);
 
 #endif // HELPER_H
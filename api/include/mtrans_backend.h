@@ -0,0 +1,65 @@
+//  Author: Arjun Ramaswami
+
+#ifndef MTRANS_BACKEND_H
+#define MTRANS_BACKEND_H
+
+#include <stddef.h>
+#include "transpose_fpga.h"
+
+// Options passed to a backend on initialization
+typedef struct mtrans_opts {
+  const char *platform;  // fpga: name of the OpenCL platform
+  const char *path;      // fpga: path to bitstream
+  int use_svm;           // fpga: svm based pcie transfers
+  int use_emulator;      // fpga: emulated device
+  int isND;              // fpga: kernel is ND Range
+  int threads;           // cpu: number of workers, 0 for all cores
+  int bitreverse;        // sim: model the bitreversed i/o kernel variants
+  int inplace;           // fpga: a single device buffer per batch
+} mtrans_opts_t;
+
+// Host interface of a device that transposes batches of N x N matrices
+typedef struct mtrans_backend {
+  const char *name;
+
+  // setup the device, 0 if successful
+  int (*init)(const mtrans_opts_t *opts);
+
+  // host memory suitable for transfers to the device
+  void* (*alloc)(size_t sz);
+  void (*dealloc)(void *ptr);
+
+  // batched transposition with the semantics of mTranspose
+  fpga_t (*transpose)(int N, float2 *inp, float2 *out, int batch);
+
+  // release the device
+  void (*finalize)();
+} mtrans_backend_t;
+
+#ifdef USE_FPGA
+extern const mtrans_backend_t fpga_backend;
+#endif
+extern const mtrans_backend_t cpu_backend;
+extern const mtrans_backend_t sim_backend;
+
+// Find a backend by name, NULL if not available in this build
+const mtrans_backend_t* mtrans_find_backend(const char *name);
+
+// 64-byte aligned host memory for backends without special requirements,
+// recycled by size across calls
+void* mtrans_host_alloc(size_t sz);
+void mtrans_host_free(void *ptr);
+
+// As mtrans_host_alloc, created set to 1 if the memory is new, not recycled
+void* mtrans_host_acquire(size_t sz, int *created);
+
+// Cap the bytes of host memory in use and kept for reuse, 0 for no limit
+void mtrans_host_pool_limit(size_t bytes);
+
+// Hits, misses and bytes of the host memory
+void mtrans_host_pool_stats(fpga_pool_stats_t *stats);
+
+// Release the host memory kept for reuse
+void mtrans_host_trim();
+
+#endif // MTRANS_BACKEND_H
@@ -0,0 +1,73 @@
+//  Author: Arjun Ramaswami
+
+#ifndef PERF_MODEL_H
+#define PERF_MODEL_H
+
+// Width of the memory bus of a DDR bank in bytes
+#define PERF_BUS_BYTES (512 / 8)
+
+// Batches simulated cycle by cycle, larger batches are extrapolated
+#define PERF_SIM_BATCH 4
+
+// How a kernel buffers data between its input and output
+typedef enum {
+  STAGE_GROUP,     // fills a group of words before emitting them
+  STAGE_LOCKSTEP   // reads and writes a word every step, see diagonal_opt.cl
+} stage_kind;
+
+// Number of words in a group
+typedef enum {
+  GROUP_WORD,      // single work item kernels, no buffering
+  GROUP_WORKGROUP, // ND range kernels with local buffer of N words
+  GROUP_MATRIX     // N * N / POINTS words, a complete matrix
+} stage_group;
+
+typedef struct stage_desc {
+  stage_kind kind;
+  stage_group group;
+  unsigned slots;  // groups buffered at the same time
+} stage_desc_t;
+
+// Structure of the fetch, transpose and store kernels of a bitstream
+typedef struct perf_variant {
+  const char *name;
+  stage_desc_t fetch, transpose, store;
+  unsigned chan_depth;  // depth of the channels, 0 if POINTS
+  unsigned banked;      // a pipeline per bank, reading and writing its bank
+  unsigned replicated;  // repl pipelines sharing the bandwidth of the banks
+} perf_variant_t;
+
+typedef struct perf_params {
+  unsigned logn;
+  unsigned logpoints;
+  unsigned banks;       // DDR banks feeding fetch, and store
+  double freq_mhz;      // kernel frequency
+  double mem_freq_mhz;  // memory controller frequency
+  unsigned chan_depth;  // overrides the depth of the variant if not 0
+  unsigned elem_sz;     // bytes of an element, 2 to 16
+  unsigned repl;        // pipelines of replicated variants
+} perf_params_t;
+
+// Predicted execution of a batch of transpositions
+typedef struct perf_result {
+  unsigned long cycles;
+  unsigned long first_cycles;           // until first matrix is stored
+  unsigned long fetch_mem_stalls;       // memory bandwidth
+  unsigned long fetch_full_stalls;      // chaninTranspose full
+  unsigned long transpose_empty_stalls; // chaninTranspose empty
+  unsigned long transpose_full_stalls;  // chanoutTranspose full
+  unsigned long store_empty_stalls;     // chanoutTranspose empty
+  unsigned long store_mem_stalls;       // memory bandwidth
+  double exec_t;                        // batch execution in ms
+} perf_result_t;
+
+// Find a kernel variant by name, NULL if not modelled
+const perf_variant_t* perf_find_variant(const char *name);
+
+// Kernel variant by index, NULL beyond the last
+const perf_variant_t* perf_variant(unsigned i);
+
+// Predict cycles and stalls of a batch of transpositions
+perf_result_t perf_model(const perf_variant_t *variant, const perf_params_t *params, int batch);
+
+#endif // PERF_MODEL_H
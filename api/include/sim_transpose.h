@@ -0,0 +1,26 @@
+//  Author: Arjun Ramaswami
+
+#ifndef SIM_TRANSPOSE_H
+#define SIM_TRANSPOSE_H
+
+#include <stdbool.h>
+#include "transpose_fpga.h"
+
+// Frequency of the simulated kernels used to convert cycles to time
+#define SIM_FREQ_MHZ 300.0
+
+// Depth of the simulated channels between kernels
+#define SIM_CHANNEL_DEPTH 8
+
+// Cycles and stalls of the last simulated execution
+typedef struct sim_stats {
+  unsigned long cycles;
+  unsigned long fetch_stalls;      // chaninTranspose full
+  unsigned long transpose_stalls;  // chaninTranspose empty or chanoutTranspose full
+  unsigned long store_stalls;      // chanoutTranspose empty
+} sim_stats_t;
+
+// Functional simulation of the fetch, transpose and store kernels
+sim_stats_t sim_mTranspose(int N, const float2 *src, float2 *dest, int batch, bool bitreverse);
+
+#endif // SIM_TRANSPOSE_H
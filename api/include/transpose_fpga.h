@@ -3,6 +3,9 @@
 #ifndef TRANSPOSE_FPGA_H
 #define TRANSPOSE_FPGA_H
 
+#include <stddef.h>
+#include <stdint.h>
+
 typedef struct {
   float x;
   float y;
@@ -13,6 +16,16 @@ typedef struct {
   double y;
 } double2;
 
+// IEEE 754 half precision, only moved so kept as its bits
+typedef struct {
+  uint16_t bits;
+} half_t;
+
+// bfloat16, the upper half of a float
+typedef struct {
+  uint16_t bits;
+} bf16_t;
+
 typedef struct fpga_timing {
   double pcie_read_t;
   double pcie_write_t;
@@ -20,16 +33,232 @@ typedef struct fpga_timing {
   int valid;
 } fpga_t;
 
+// Device timestamps of a command in milliseconds, relative to the first
+// command of the execution queued
+typedef struct fpga_event_times {
+  double queued;
+  double submit;  // dependencies met, submitted to the device
+  double start;
+  double end;
+} fpga_event_times_t;
+
+// Device side profile of an execution from the events of its commands
+typedef struct fpga_profile {
+  fpga_event_times_t write, fetch, transpose, store, read;
+  double launch_t;    // kernels submitted until the first starts
+  double pipeline_t;  // first kernel start until the last kernel end
+  int valid;
+} fpga_profile_t;
+
+// Distribution of the points of a rectangular transposition
+typedef struct fpga_tiling {
+  size_t points;         // rows * cols * batch
+  size_t fpga_points;    // transferred in tiles, including padding
+  size_t padded_points;  // padding of partial tiles
+  size_t cpu_points;     // remainders transposed on the cpu
+} fpga_tiling_t;
+
+// FPGAs of a platform a batch is spread across
+#define FPGA_MAX_DEVICES 8
+
+// Slices of a batch transposed by every FPGA
+typedef struct fpga_multi {
+  int devices;
+  int batch[FPGA_MAX_DEVICES];
+  fpga_t timing[FPGA_MAX_DEVICES];
+  double total_t;  // wall time of all devices in milliseconds
+} fpga_multi_t;
+
+// Persistent queues, kernels and device buffers for a given size and batch
+typedef struct fpga_plan fpga_plan_t;
+
+// Transposition in flight, returned by mTranspose_submit()
+typedef struct fpga_request fpga_request_t;
+
+// Called once a request completed, on a thread of the OpenCL runtime
+typedef void (*fpga_callback_t)(fpga_request_t *req, fpga_t timing, void *user_data);
+
+// Counters of a pool of buffers recycled across calls
+typedef struct fpga_pool_stats {
+  size_t hits;        // acquires served by an idle buffer
+  size_t misses;      // acquires that created a buffer
+  size_t evictions;   // idle buffers released to stay within the cap
+  size_t used_bytes;  // buffers handed out
+  size_t idle_bytes;  // buffers kept for reuse
+  size_t peak_bytes;
+  size_t cap_bytes;   // 0 for no limit
+} fpga_pool_stats_t;
+
+// Files of matrices transposed by mTranspose_file()
+typedef struct fpga_file {
+  size_t matrices;  // N x N matrices of the input file
+  size_t window;    // matrices of a window of the mapped files
+  size_t windows;
+} fpga_file_t;
+
+// Aggregates concurrent transpositions of the same N into batched launches
+typedef struct fpga_coalescer fpga_coalescer_t;
+
+// Batching achieved by a coalescer
+typedef struct fpga_coalesce_stats {
+  size_t requests;     // transpositions submitted by callers
+  size_t launches;     // batched executions on the device
+  size_t matrices;     // matrices of all launches
+  size_t full;         // launches of a full batch, before the budget expired
+  int max_batch;       // matrices of the largest launch
+  double avg_batch;    // matrices per launch
+  double avg_queue_t;  // milliseconds a request waited for its launch
+  double max_queue_t;
+} fpga_coalesce_stats_t;
+
 // Initialize FPGA
 extern int fpga_initialize(const char *platform_name, const char *path, int use_svm, int use_emulator);
 
 // Finalize FPGA
 extern void fpga_final();
 
+// Pipelines of a banked or replicated bitstream, 0 if it has a single pipeline
+extern int fpga_banks();
+
+// DDR banks the pipelines of a replicated bitstream are spread over, 0 if not
+// replicated
+extern int fpga_replicated_banks();
+
+// 1 if the kernels of the bitstream are launched once per plan and fed the
+// transpositions of its executions through a doorbell
+extern int fpga_persistent();
+
+// Length of the matrices of the bitstream, the largest if sized at runtime,
+// 0 if it does not report it
+extern int fpga_size();
+
+// 1 if the bitstream transposes any length up to fpga_size() given at runtime
+extern int fpga_runtime_size();
+
+// Elements moved per cycle by the bitstream, 0 if it does not report it
+extern int fpga_points();
+
+// Largest batch of N x N matrices of a plan within the device memory, in
+// place if inplace is 1
+extern int fpga_max_batch(int N, int inplace);
+
+// Number of FPGAs of the platform, each loaded with the bitstream
+extern int fpga_devices();
+
 // Single precision complex memory allocation
 extern void* fpgaf_complex_malloc(size_t sz, int svm);;
 
+// Double precision complex memory allocation
+extern void* fpgad_complex_malloc(size_t sz, int svm);
+
+// Release memory of the allocations above, svm memory before fpga_final()
+extern void fpga_complex_free(void *ptr);
+
+// 1 if svm memory is shared with the kernels, 0 if pinned for DMA transfers
+extern int fpga_svm_shared();
+
+// Cap the bytes of device buffers of plans in use and kept for reuse, 0 for
+// no limit
+extern void fpga_pool_limit(size_t bytes);
+
+// Hits, misses and bytes of the pool of device buffers
+extern void fpga_pool_stats(fpga_pool_stats_t *stats);
+
 // Single precision Matrix Transpose
 fpga_t mTranspose(int N, float2 *inp, float2 *out, int batch, int use_svm, int isND);
 
+// Create a plan to transpose upto batch N x N matrices per execution
+extern fpga_plan_t* mTranspose_plan(int N, int batch, int isND);
+
+// Transpose using the resources of an existing plan
+extern fpga_t mTranspose_execute(fpga_plan_t *plan, float2 *inp, float2 *out, int batch);
+
+// Single precision Matrix Transpose in place, a single device buffer per batch
+fpga_t mTranspose_inplace(int N, float2 *data, int batch, int isND);
+
+// Create a plan storing every matrix over the device buffer it was fetched
+// from, transposing twice the batch of mTranspose_plan() in the same memory
+extern fpga_plan_t* mTranspose_plan_inplace(int N, int batch, int isND);
+
+// Transpose data in place using an existing plan
+extern fpga_t mTranspose_execute_inplace(fpga_plan_t *plan, float2 *data, int batch);
+
+// Device side profile of the last execution of a plan, 0 if valid
+extern int mTranspose_profile(const fpga_plan_t *plan, fpga_profile_t *prof);
+
+// Transpose a large batch in chunks of the plan's batch, overlapping PCIe
+// transfers with kernel execution
+extern fpga_t mTranspose_stream(fpga_plan_t *plan, float2 *inp, float2 *out, int batch);
+
+// Transpose the matrices of a file into another, streaming windows of the
+// mapped files through the plan with bounded resident memory
+extern fpga_t mTranspose_file(fpga_plan_t *plan, const char *in_path, const char *out_path, fpga_file_t *file);
+
+// Submit a transposition using an existing plan, returns without waiting
+extern fpga_request_t* mTranspose_submit(fpga_plan_t *plan, float2 *inp, float2 *out, int batch, fpga_callback_t callback, void *user_data);
+
+// 1 if the request completed, 0 otherwise
+extern int mTranspose_poll(fpga_request_t *req);
+
+// Wait for the request to complete and return its timing
+extern fpga_t mTranspose_wait(fpga_request_t *req);
+
+// Device side profile of a completed request, 0 if valid
+extern int mTranspose_request_profile(fpga_request_t *req, fpga_profile_t *prof);
+
+// Release a request, freed on completion if still in flight
+extern void mTranspose_release(fpga_request_t *req);
+
+// Coalesce transpositions of concurrent callers into launches of upto
+// max_batch N x N matrices, each request waiting at most budget_ms for others
+extern fpga_coalescer_t* mTranspose_coalescer(int N, int max_batch, double budget_ms, int isND);
+
+// Transpose together with concurrent callers, blocks until transposed
+extern fpga_t mTranspose_coalesce(fpga_coalescer_t *co, float2 *inp, float2 *out, int batch);
+
+// Achieved batch sizes and queueing delay of a coalescer
+extern void mTranspose_coalesce_stats(fpga_coalescer_t *co, fpga_coalesce_stats_t *stats);
+
+// Launch the queued requests and release the coalescer
+extern void mTranspose_coalescer_destroy(fpga_coalescer_t *co);
+
+// Transpose a batch spread across every FPGA in proportion to their throughput
+extern fpga_t mTranspose_multi(int N, float2 *inp, float2 *out, int batch, int isND, fpga_multi_t *multi);
+
+// Transpose rows x cols matrices in tiles of the plan's N, remainders on cpu
+extern fpga_t mTranspose_rect(fpga_plan_t *plan, int rows, int cols, float2 *inp, float2 *out, int batch, fpga_tiling_t *tiling);
+
+// Double precision variants, require a bitstream built with TYPE double2
+fpga_t mTranspose_d(int N, double2 *inp, double2 *out, int batch, int use_svm, int isND);
+
+extern fpga_plan_t* mTranspose_plan_d(int N, int batch, int isND);
+
+extern fpga_t mTranspose_execute_d(fpga_plan_t *plan, double2 *inp, double2 *out, int batch);
+
+extern fpga_t mTranspose_stream_d(fpga_plan_t *plan, double2 *inp, double2 *out, int batch);
+
+// Real single precision variants, require a bitstream built with TYPE float
+extern fpga_plan_t* mTranspose_plan_r(int N, int batch, int isND);
+
+extern fpga_t mTranspose_execute_r(fpga_plan_t *plan, float *inp, float *out, int batch);
+
+extern fpga_t mTranspose_stream_r(fpga_plan_t *plan, float *inp, float *out, int batch);
+
+// Half precision variants, require a bitstream built with TYPE half
+extern fpga_plan_t* mTranspose_plan_h(int N, int batch, int isND);
+
+extern fpga_t mTranspose_execute_h(fpga_plan_t *plan, half_t *inp, half_t *out, int batch);
+
+extern fpga_t mTranspose_stream_h(fpga_plan_t *plan, half_t *inp, half_t *out, int batch);
+
+// bfloat16 variants, require a bitstream built with TYPE bf16
+extern fpga_plan_t* mTranspose_plan_bf(int N, int batch, int isND);
+
+extern fpga_t mTranspose_execute_bf(fpga_plan_t *plan, bf16_t *inp, bf16_t *out, int batch);
+
+extern fpga_t mTranspose_stream_bf(fpga_plan_t *plan, bf16_t *inp, bf16_t *out, int batch);
+
+// Release the resources of a plan
+extern void mTranspose_destroy(fpga_plan_t *plan);
+
 #endif
@@ -0,0 +1,509 @@
+//  Author: Arjun Ramaswami
+
+/*
+ * Benchmark driver sweeping matrix sizes, batches and bitstreams of a
+ * backend. Every configuration is transposed a number of times to warm up,
+ * checked against the cpu transposition, then timed over repetitions. The
+ * distribution of every phase is written as CSV or JSON, one record per
+ * configuration and phase, to be compared across builds. Sizes a bitstream
+ * does not transpose are skipped, and runtime sized bitstreams are compared
+ * with fixed size ones of the same size and batch. Bitstreams of several
+ * pipelines, banked or replicated, are compared with single pipeline ones to
+ * show how the throughput scales with the pipelines. The latency of single
+ * matrix transpositions is reported to compare persistent bitstreams, whose
+ * kernels are not launched by every transposition, with others. Bitstreams
+ * are optionally timed again in place, with a single device buffer per
+ * batch, to show its throughput and the largest batch of both.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "argparse.h"
+#include "transpose_fpga.h"
+#include "helper.h"
+#include "cpu_transpose.h"
+#include "mtrans_backend.h"
+
+// Largest number of values in a list option
+#define MAX_LIST 32
+
+// Timed phases of a transposition
+#define NUM_PHASES 4
+static const char *const phase_names[NUM_PHASES] = {"pcie_write", "exec", "pcie_read", "wall"};
+
+static const char *const usage[] = {
+    "bin/bench [options]",
+    NULL,
+};
+
+// Distribution of the times of a phase in milliseconds
+typedef struct bench_stats {
+  double min, median, p99, mean, stddev;
+} bench_stats_t;
+
+// Measures of a configuration
+typedef struct bench_result {
+  const char *backend;
+  const char *variant;
+  int N, batch, reps;
+  int verified;  // output equal to the cpu transposition
+  int runtime_size;  // fpga: bitstream sized at runtime
+  int pipelines;     // pipelines the batch is split between
+  int persistent;    // fpga: kernels launched once, fed through a doorbell
+  int inplace;       // fpga: a single device buffer per batch
+  int max_batch;     // fpga: largest batch of the device memory, 0 if unknown
+  bench_stats_t phase[NUM_PHASES];
+} bench_result_t;
+
+static int cmp_double(const void *a, const void *b){
+  double x = *(const double *)a, y = *(const double *)b;
+  return (x > y) - (x < y);
+}
+
+/**
+ * \brief  min, median, 99th percentile by nearest rank, mean and sample
+ *         standard deviation of n times. Sorts the times.
+ */
+static bench_stats_t compute_stats(double *t, int n){
+  bench_stats_t s = {0.0, 0.0, 0.0, 0.0, 0.0};
+  if(n <= 0){
+    return s;
+  }
+
+  qsort(t, n, sizeof(double), cmp_double);
+
+  s.min = t[0];
+  s.median = (n % 2) ? t[n / 2] : 0.5 * (t[(n / 2) - 1] + t[n / 2]);
+  s.p99 = t[(int)ceil(0.99 * n) - 1];
+
+  for(int i = 0; i < n; i++)
+    s.mean += t[i];
+  s.mean /= n;
+
+  for(int i = 0; i < n && n > 1; i++)
+    s.stddev += (t[i] - s.mean) * (t[i] - s.mean);
+  s.stddev = (n > 1) ? sqrt(s.stddev / (n - 1)) : 0.0;
+
+  return s;
+}
+
+/**
+ * \brief  parse a comma separated list of positive integers
+ * \retval number of values, 0 if invalid
+ */
+static int parse_list(const char *str, int *vals){
+  int n = 0;
+  const char *p = str;
+
+  while(p != NULL && *p != '\0' && n < MAX_LIST){
+    char *end;
+    long v = strtol(p, &end, 10);
+    if(end == p || v <= 0 || (*end != ',' && *end != '\0')){
+      return 0;
+    }
+    vals[n++] = (int)v;
+    p = (*end == ',') ? end + 1 : end;
+  }
+  return n;
+}
+
+/**
+ * \brief  name of a bitstream, the file name without directory and extension
+ */
+static void variant_name(const char *path, char *name, size_t len){
+  const char *base = strrchr(path, '/');
+  base = (base != NULL) ? base + 1 : path;
+
+  snprintf(name, len, "%s", base);
+  char *dot = strrchr(name, '.');
+  if(dot != NULL && dot != name)
+    *dot = '\0';
+}
+
+/**
+ * \brief  warm up, verify and time a configuration on an initialized backend
+ * \retval 0 if every repetition was valid
+ */
+static int bench_config(const mtrans_backend_t *backend, bench_result_t *r, int warmup){
+  const size_t points = (size_t)r->N * r->N * r->batch;
+  const size_t sz = sizeof(float2) * points;
+  int status = 1;
+
+  float2 *inp = (float2 *)backend->alloc(sz);
+  float2 *out = (float2 *)backend->alloc(sz);
+  float2 *ref = (float2 *)mtrans_host_alloc(sz);
+  double *times[NUM_PHASES];
+  for(int p = 0; p < NUM_PHASES; p++)
+    times[p] = (double *)malloc(sizeof(double) * r->reps);
+
+  if(inp == NULL || out == NULL || ref == NULL || times[0] == NULL || times[1] == NULL || times[2] == NULL || times[3] == NULL){
+    fprintf(stderr, "Failed to allocate %d matrices of %d x %d\n", r->batch, r->N, r->N);
+    goto cleanup;
+  }
+
+  for(size_t i = 0; i < points; i++){
+    inp[i].x = (float)i;
+    inp[i].y = -(float)(i % r->N);
+  }
+  cpu_transpose(inp, ref, r->N, r->batch);
+
+  for(int i = 0; i < warmup; i++){
+    backend->transpose(r->N, inp, out, r->batch);
+  }
+
+  for(int i = 0; i < r->reps; i++){
+    memset(out, 0, sz);
+
+    double wall = getTimeinMilliSec();
+    fpga_t t = backend->transpose(r->N, inp, out, r->batch);
+    wall = getTimeinMilliSec() - wall;
+
+    if(t.valid != 1){
+      fprintf(stderr, "Invalid transposition of %d x %d, batch %d\n", r->N, r->N, r->batch);
+      goto cleanup;
+    }
+    times[0][i] = t.pcie_write_t;
+    times[1][i] = t.exec_t;
+    times[2][i] = t.pcie_read_t;
+    times[3][i] = wall;
+  }
+
+  // output of the last repetition
+  r->verified = (memcmp(out, ref, sz) == 0);
+
+  for(int p = 0; p < NUM_PHASES; p++)
+    r->phase[p] = compute_stats(times[p], r->reps);
+  status = 0;
+
+cleanup:
+  for(int p = 0; p < NUM_PHASES; p++)
+    free(times[p]);
+  backend->dealloc(inp);
+  backend->dealloc(out);
+  mtrans_host_free(ref);
+  return status;
+}
+
+/**
+ * \brief  throughput in GB/s of a phase, the input or output bytes for a
+ *         transfer, both for the execution and the wall time
+ */
+static double gbytes_per_sec(const bench_result_t *r, int phase, double ms){
+  double copies = (phase == 0 || phase == 2) ? 1.0 : 2.0;
+  double gbytes = copies * sizeof(float2) * r->N * r->N * r->batch * 1e-9;
+  return (ms > 0.0) ? gbytes / (ms * 1e-3) : 0.0;
+}
+
+static void write_csv_header(FILE *f){
+  fprintf(f, "backend,variant,n,batch,reps,verified,runtime_size,pipelines,persistent,inplace,max_batch,phase,min_ms,median_ms,p99_ms,mean_ms,stddev_ms,median_gbps\n");
+}
+
+static void write_csv(FILE *f, const bench_result_t *r){
+  for(int p = 0; p < NUM_PHASES; p++){
+    const bench_stats_t *s = &r->phase[p];
+    fprintf(f, "%s,%s,%d,%d,%d,%d,%d,%d,%d,%d,%d,%s,%.6lf,%.6lf,%.6lf,%.6lf,%.6lf,%.4lf\n",
+      r->backend, r->variant, r->N, r->batch, r->reps, r->verified,
+      r->runtime_size, r->pipelines, r->persistent, r->inplace, r->max_batch, phase_names[p],
+      s->min, s->median, s->p99, s->mean, s->stddev, gbytes_per_sec(r, p, s->median));
+  }
+}
+
+static void write_json(FILE *f, const bench_result_t *r, int first){
+  fprintf(f, "%s  {\"backend\": \"%s\", \"variant\": \"%s\", \"n\": %d, \"batch\": %d, \"reps\": %d, \"verified\": %s, ",
+    first ? "" : ",\n", r->backend, r->variant, r->N, r->batch, r->reps, r->verified ? "true" : "false");
+  fprintf(f, "\"runtime_size\": %s, \"pipelines\": %d, \"persistent\": %s, \"inplace\": %s, \"max_batch\": %d, \"phases\": {",
+    r->runtime_size ? "true" : "false", r->pipelines, r->persistent ? "true" : "false", r->inplace ? "true" : "false", r->max_batch);
+  for(int p = 0; p < NUM_PHASES; p++){
+    const bench_stats_t *s = &r->phase[p];
+    fprintf(f, "%s\"%s\": {\"min_ms\": %.6lf, \"median_ms\": %.6lf, \"p99_ms\": %.6lf, \"mean_ms\": %.6lf, \"stddev_ms\": %.6lf, \"median_gbps\": %.4lf}",
+      p ? ", " : "", phase_names[p], s->min, s->median, s->p99, s->mean, s->stddev, gbytes_per_sec(r, p, s->median));
+  }
+  fprintf(f, "}}");
+}
+
+/**
+ * \brief  compare the median execution throughput of bitstreams of several
+ *         pipelines with single pipeline ones of the same N and batch on
+ *         stderr, the efficiency being the speedup per pipeline
+ */
+static void report_pipeline_scaling(const bench_result_t *res, int num){
+  int header = 0;
+
+  for(int i = 0; i < num; i++){
+    if(res[i].pipelines <= 1)
+      continue;
+    double multi = gbytes_per_sec(&res[i], 1, res[i].phase[1].median);
+
+    for(int j = 0; j < num; j++){
+      // single pipeline baseline of launched kernels and separate buffers
+      if(res[j].pipelines != 1 || res[j].runtime_size || res[j].persistent || res[j].inplace)
+        continue;
+      if(res[j].N != res[i].N || res[j].batch != res[i].batch)
+        continue;
+      double single = gbytes_per_sec(&res[j], 1, res[j].phase[1].median);
+      double speedup = (single > 0.0) ? multi / single : 0.0;
+
+      if(!header){
+        fprintf(stderr, "\nPipelines vs single pipeline, median exec GB/s\n");
+        fprintf(stderr, "%-24s %-24s %6s %6s %9s %10s %10s %8s %10s\n", "pipelined", "single", "n", "batch", "pipelines", "pipelined", "single", "speedup", "efficiency");
+        header = 1;
+      }
+      fprintf(stderr, "%-24s %-24s %6d %6d %9d %10.4lf %10.4lf %8.3lf %10.3lf\n", res[i].variant, res[j].variant, res[i].N, res[i].batch, res[i].pipelines, multi, single, speedup, speedup / res[i].pipelines);
+    }
+  }
+}
+
+/**
+ * \brief  median and 99th percentile latency of the transpositions of a
+ *         single matrix on stderr, dominated by the launch of the kernels
+ *         unless persistent
+ */
+static void report_single_latency(const bench_result_t *res, int num){
+  int header = 0;
+
+  for(int i = 0; i < num; i++){
+    if(res[i].batch != 1)
+      continue;
+
+    if(!header){
+      fprintf(stderr, "\nSingle matrix latency, ms\n");
+      fprintf(stderr, "%-24s %6s %10s %10s %10s %10s %10s\n", "variant", "n", "persistent", "exec p50", "exec p99", "wall p50", "wall p99");
+      header = 1;
+    }
+    fprintf(stderr, "%-24s %6d %10s %10.4lf %10.4lf %10.4lf %10.4lf\n", res[i].variant, res[i].N, res[i].persistent ? "yes" : "no", res[i].phase[1].median, res[i].phase[1].p99, res[i].phase[3].median, res[i].phase[3].p99);
+  }
+}
+
+/**
+ * \brief  compare the median execution and wall throughput of bitstreams
+ *         timed in place with the same bitstreams and batch timed with an
+ *         input and an output buffer on stderr, and their largest batches
+ */
+static void report_inplace_effect(const bench_result_t *res, int num){
+  char name[256 + 8];
+  int header = 0;
+
+  for(int i = 0; i < num; i++){
+    if(!res[i].inplace)
+      continue;
+
+    for(int j = 0; j < num; j++){
+      snprintf(name, sizeof(name), "%s_inplace", res[j].variant);
+      if(res[j].inplace || strcmp(name, res[i].variant) != 0 || res[j].N != res[i].N || res[j].batch != res[i].batch)
+        continue;
+      double in_exec = gbytes_per_sec(&res[i], 1, res[i].phase[1].median), sep_exec = gbytes_per_sec(&res[j], 1, res[j].phase[1].median);
+      double in_wall = gbytes_per_sec(&res[i], 3, res[i].phase[3].median), sep_wall = gbytes_per_sec(&res[j], 3, res[j].phase[3].median);
+
+      if(!header){
+        fprintf(stderr, "\nIn place vs separate buffers, median GB/s\n");
+        fprintf(stderr, "%-24s %6s %6s %10s %10s %10s %10s %10s %10s\n", "variant", "n", "batch", "exec sep", "exec in", "wall sep", "wall in", "max sep", "max in");
+        header = 1;
+      }
+      fprintf(stderr, "%-24s %6d %6d %10.4lf %10.4lf %10.4lf %10.4lf %10d %10d\n", res[j].variant, res[i].N, res[i].batch, sep_exec, in_exec, sep_wall, in_wall, res[j].max_batch, res[i].max_batch);
+    }
+  }
+}
+
+/**
+ * \brief  compare the median execution throughput of runtime sized
+ *         bitstreams with fixed size ones of the same N and batch on stderr
+ */
+static void report_runtime_cost(const bench_result_t *res, int num){
+  int header = 0;
+
+  for(int i = 0; i < num; i++){
+    if(!res[i].runtime_size)
+      continue;
+    double rt = gbytes_per_sec(&res[i], 1, res[i].phase[1].median);
+
+    for(int j = 0; j < num; j++){
+      // fixed size baseline of a single pipeline, launched kernels and separate buffers
+      if(res[j].runtime_size || res[j].pipelines != 1 || res[j].persistent || res[j].inplace)
+        continue;
+      if(res[j].N != res[i].N || res[j].batch != res[i].batch)
+        continue;
+      double fx = gbytes_per_sec(&res[j], 1, res[j].phase[1].median);
+
+      if(!header){
+        fprintf(stderr, "\nRuntime vs fixed size, median exec GB/s\n");
+        fprintf(stderr, "%-24s %-24s %6s %6s %10s %10s %8s\n", "runtime", "fixed", "n", "batch", "runtime", "fixed", "ratio");
+        header = 1;
+      }
+      fprintf(stderr, "%-24s %-24s %6d %6d %10.4lf %10.4lf %8.3lf\n", res[i].variant, res[j].variant, res[i].N, res[i].batch, rt, fx, (fx > 0.0) ? rt / fx : 0.0);
+    }
+  }
+}
+
+int main(int argc, const char **argv) {
+
+  const char *sizes = "64", *batches = "1", *paths = NULL;
+  const char *backend_name = "fpga", *format = "csv", *output = NULL;
+  const char *platform = "Intel(R) FPGA";
+  int warmup = 2, reps = 10, threads = 0, use_svm = 0, inplace = 0;
+
+  struct argparse_option options[] = {
+    OPT_HELP(),
+    OPT_GROUP("Basic Options"),
+    OPT_STRING('n', "n", &sizes, "Lengths of square matrices, comma separated"),
+    OPT_STRING('b', "b", &batches, "Batches, comma separated"),
+    OPT_STRING('p', "path", &paths, "Bitstreams of the kernel variants, comma separated"),
+    OPT_STRING('k', "backend", &backend_name, "Backend: fpga, cpu or sim"),
+    OPT_INTEGER('w', "warmup", &warmup, "Untimed transpositions per configuration"),
+    OPT_INTEGER('r', "reps", &reps, "Timed repetitions per configuration"),
+    OPT_INTEGER('t', "threads", &threads, "Number of threads of the cpu backend"),
+    OPT_STRING('f', "format", &format, "Output format: csv or json"),
+    OPT_STRING('o', "output", &output, "Output file, stdout if none"),
+    OPT_BOOLEAN('v', "svm", &use_svm, "Use SVM, shared with the kernels or pinned"),
+    OPT_BOOLEAN('i', "inplace", &inplace, "Also time every bitstream in place, a device buffer per batch"),
+    OPT_END(),
+  };
+
+  struct argparse argparse;
+  argparse_init(&argparse, options, usage, 0);
+  argparse_describe(&argparse, "Benchmarking Matrix Transpose", "Distributions of every phase over repetitions, progress on stderr");
+  argc = argparse_parse(&argparse, argc, argv);
+
+  int N[MAX_LIST], batch[MAX_LIST];
+  int num_n = parse_list(sizes, N), num_batch = parse_list(batches, batch);
+  int json = (strcmp(format, "json") == 0);
+
+  if(num_n == 0 || num_batch == 0 || warmup < 0 || reps < 1 || (!json && strcmp(format, "csv") != 0)){
+    fprintf(stderr, "Invalid benchmark parameters\n");
+    return 1;
+  }
+
+  const mtrans_backend_t *backend = mtrans_find_backend(backend_name);
+  if(backend == NULL){
+    fprintf(stderr, "Backend %s not available\n", backend_name);
+    return 1;
+  }
+  int is_fpga = (strcmp(backend->name, "fpga") == 0);
+
+  // a variant per bitstream on the fpga, the backend itself otherwise
+  char *path_list = strdup((is_fpga && paths != NULL) ? paths : "");
+  char *variants[2 * MAX_LIST];
+  int in_place[2 * MAX_LIST] = {0};
+  int num_variants = 0;
+  for(char *tok = strtok(path_list, ","); tok != NULL && num_variants < MAX_LIST; tok = strtok(NULL, ",")){
+    variants[num_variants++] = tok;
+  }
+  if(is_fpga && num_variants == 0){
+    fprintf(stderr, "Path to a bitstream missing\n");
+    free(path_list);
+    return 1;
+  }
+  if(!is_fpga){
+    variants[num_variants++] = NULL;
+  }
+
+  // bitstreams timed again in place
+  const int num_paths = num_variants;
+  for(int v = 0; inplace && is_fpga && v < num_paths; v++){
+    variants[num_variants] = variants[v];
+    in_place[num_variants++] = 1;
+  }
+
+  FILE *f = (output != NULL) ? fopen(output, "w") : stdout;
+  if(f == NULL){
+    fprintf(stderr, "Failed to open %s\n", output);
+    free(path_list);
+    return 1;
+  }
+
+  if(json)
+    fprintf(f, "[\n");
+  else
+    write_csv_header(f);
+
+  // kept to compare runtime sized and pipelined bitstreams with others
+  bench_result_t *results = (bench_result_t *)calloc((size_t)num_variants * num_n * num_batch, sizeof(bench_result_t));
+  char names[2 * MAX_LIST][256];
+  int num_results = 0;
+
+  int status = 0, first = 1;
+  for(int v = 0; v < num_variants && results != NULL; v++){
+    char *name = names[v];
+    variant_name(variants[v] ? variants[v] : backend->name, name, sizeof(names[v]) - 8);
+    if(in_place[v])
+      strcat(name, "_inplace");
+
+    mtrans_opts_t opts = {platform, variants[v], use_svm, 0, 0, threads, 0, in_place[v]};
+    if(backend->init(&opts)){
+      fprintf(stderr, "Failed to initialize %s for %s\n", backend->name, name);
+      status = 1;
+      continue;
+    }
+
+    for(int i = 0; i < num_n; i++){
+#ifdef USE_FPGA
+      // other sizes than the one of a fixed size bitstream, or beyond the
+      // largest of a runtime sized one
+      if(is_fpga && fpga_size() > 0 && (fpga_runtime_size() ? (N[i] > fpga_size()) : (N[i] != fpga_size()))){
+        fprintf(stderr, "%s %s: N = %d skipped, bitstream of N %s %d\n", backend->name, name, N[i], fpga_runtime_size() ? "up to" : "=", fpga_size());
+        continue;
+      }
+#endif
+      for(int j = 0; j < num_batch; j++){
+        bench_result_t r;
+        memset(&r, 0, sizeof(bench_result_t));
+        r.backend = backend->name;
+        r.variant = name;
+        r.N = N[i];
+        r.batch = batch[j];
+        r.reps = reps;
+#ifdef USE_FPGA
+        r.runtime_size = is_fpga && fpga_runtime_size();
+        r.pipelines = (is_fpga && fpga_banks() > 0) ? fpga_banks() : 1;
+        r.persistent = is_fpga && fpga_persistent();
+        r.inplace = in_place[v];
+        r.max_batch = is_fpga ? fpga_max_batch(N[i], in_place[v]) : 0;
+#else
+        r.pipelines = 1;
+#endif
+
+        fprintf(stderr, "%s %s: N = %d, batch = %d\n", r.backend, r.variant, r.N, r.batch);
+        if(bench_config(backend, &r, warmup)){
+          status = 1;
+          continue;
+        }
+        if(!r.verified){
+          fprintf(stderr, "%s %s: N = %d, batch = %d transposed incorrectly\n", r.backend, r.variant, r.N, r.batch);
+          status = 1;
+        }
+
+        if(json)
+          write_json(f, &r, first);
+        else
+          write_csv(f, &r);
+        first = 0;
+        results[num_results++] = r;
+      }
+    }
+
+    backend->finalize();
+  }
+
+  if(json)
+    fprintf(f, "\n]\n");
+
+  if(results == NULL){
+    fprintf(stderr, "Failed to allocate results\n");
+    status = 1;
+  }
+  else{
+    report_runtime_cost(results, num_results);
+    report_pipeline_scaling(results, num_results);
+    report_single_latency(results, num_results);
+    report_inplace_effect(results, num_results);
+  }
+
+  if(f != stdout)
+    fclose(f);
+  free(results);
+  free(path_list);
+  mtrans_host_trim();
+  return status;
+}
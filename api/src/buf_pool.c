@@ -0,0 +1,247 @@
+//  Author: Arjun Ramaswami
+
+/*
+ * Pool of buffers recycled across calls instead of created and released by
+ * every call. Buffers are matched by their exact size and a key, the memory
+ * bank of device buffers, as the same sizes recur from call to call.
+ *
+ * Released buffers are kept idle, most recently released first, and handed
+ * out again by the next acquire of the same size and key. The bytes of the
+ * buffers in use and idle are capped: a miss releases idle buffers, least
+ * recently released first, until the new buffer fits, and fails if it still
+ * does not.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+
+#include "transpose_fpga.h"
+#include "buf_pool.h"
+
+typedef struct pool_entry {
+  void *buf;
+  size_t sz;
+  uint64_t key;
+  struct pool_entry *next;
+} pool_entry_t;
+
+struct buf_pool {
+  buf_create_fn create;
+  buf_destroy_fn destroy;
+  pthread_mutex_t lock;
+  pool_entry_t *used;  // buffers handed out
+  pool_entry_t *idle;  // most recently released first
+  fpga_pool_stats_t stats;
+};
+
+/**
+ * \brief  release the least recently released idle buffer
+ * \retval 0 if one was released, -1 if none is idle
+ */
+static int evict_one(buf_pool_t *pool){
+  pool_entry_t **prev = &pool->idle;
+
+  if(*prev == NULL)
+    return -1;
+
+  while((*prev)->next != NULL)
+    prev = &(*prev)->next;
+
+  pool_entry_t *e = *prev;
+  *prev = NULL;
+  pool->destroy(e->buf, e->sz, e->key);
+  pool->stats.idle_bytes -= e->sz;
+  pool->stats.evictions++;
+  free(e);
+  return 0;
+}
+
+/**
+ * \brief  release idle buffers until the pool is within its cap
+ */
+static void evict_to_cap(buf_pool_t *pool, size_t extra){
+  fpga_pool_stats_t *s = &pool->stats;
+
+  while(s->cap_bytes > 0 && s->used_bytes + s->idle_bytes + extra > s->cap_bytes){
+    if(evict_one(pool) != 0)
+      break;
+  }
+}
+
+/**
+ * \brief  create a pool of buffers
+ * \param  cap     : bytes of the buffers in use and idle, 0 for no limit
+ * \param  create  : allocate a buffer of a size and key
+ * \param  destroy : release a buffer
+ * \retval pool or NULL
+ */
+buf_pool_t* buf_pool_create(size_t cap, buf_create_fn create, buf_destroy_fn destroy){
+  if(create == NULL || destroy == NULL){
+    return NULL;
+  }
+
+  buf_pool_t *pool = (buf_pool_t *)calloc(1, sizeof(buf_pool_t));
+  if(pool == NULL){
+    return NULL;
+  }
+
+  pool->create = create;
+  pool->destroy = destroy;
+  pool->stats.cap_bytes = cap;
+  pthread_mutex_init(&pool->lock, NULL);
+  return pool;
+}
+
+/**
+ * \brief  hand out an idle buffer of the same size and key, else create one
+ * \param  created : if not NULL, set to 1 if the buffer was created, 0 if
+ *                   recycled
+ * \retval buffer or NULL if it cannot be created within the cap
+ */
+void* buf_pool_acquire(buf_pool_t *pool, size_t sz, uint64_t key, int *created){
+  if(created != NULL)
+    *created = 0;
+  if(pool == NULL || sz == 0){
+    return NULL;
+  }
+
+  pthread_mutex_lock(&pool->lock);
+
+  pool_entry_t **prev = &pool->idle;
+  while(*prev != NULL && ((*prev)->sz != sz || (*prev)->key != key))
+    prev = &(*prev)->next;
+
+  pool_entry_t *e = *prev;
+  if(e != NULL){
+    *prev = e->next;
+    pool->stats.idle_bytes -= sz;
+    pool->stats.hits++;
+  }
+  else{
+    pool->stats.misses++;
+    evict_to_cap(pool, sz);
+
+    fpga_pool_stats_t *s = &pool->stats;
+    e = (pool_entry_t *)malloc(sizeof(pool_entry_t));
+    if(e == NULL || (s->cap_bytes > 0 && s->used_bytes + s->idle_bytes + sz > s->cap_bytes)){
+      pthread_mutex_unlock(&pool->lock);
+      free(e);
+      return NULL;
+    }
+
+    e->buf = pool->create(sz, key);
+    if(e->buf == NULL){
+      pthread_mutex_unlock(&pool->lock);
+      free(e);
+      return NULL;
+    }
+    e->sz = sz;
+    e->key = key;
+    if(created != NULL)
+      *created = 1;
+  }
+
+  e->next = pool->used;
+  pool->used = e;
+  pool->stats.used_bytes += sz;
+  if(pool->stats.used_bytes + pool->stats.idle_bytes > pool->stats.peak_bytes)
+    pool->stats.peak_bytes = pool->stats.used_bytes + pool->stats.idle_bytes;
+
+  void *buf = e->buf;
+  pthread_mutex_unlock(&pool->lock);
+  return buf;
+}
+
+/**
+ * \brief  return a buffer acquired from the pool for reuse
+ * \retval 0 if released, -1 if the buffer is not from the pool
+ */
+int buf_pool_release(buf_pool_t *pool, void *buf){
+  if(pool == NULL || buf == NULL){
+    return -1;
+  }
+
+  pthread_mutex_lock(&pool->lock);
+
+  pool_entry_t **prev = &pool->used;
+  while(*prev != NULL && (*prev)->buf != buf)
+    prev = &(*prev)->next;
+
+  pool_entry_t *e = *prev;
+  if(e == NULL){
+    pthread_mutex_unlock(&pool->lock);
+    return -1;
+  }
+
+  *prev = e->next;
+  pool->stats.used_bytes -= e->sz;
+
+  e->next = pool->idle;
+  pool->idle = e;
+  pool->stats.idle_bytes += e->sz;
+  evict_to_cap(pool, 0);
+
+  pthread_mutex_unlock(&pool->lock);
+  return 0;
+}
+
+/**
+ * \brief  change the cap of a pool, releasing idle buffers beyond it
+ * \param  cap : bytes of the buffers in use and idle, 0 for no limit
+ */
+void buf_pool_limit(buf_pool_t *pool, size_t cap){
+  if(pool == NULL)
+    return;
+
+  pthread_mutex_lock(&pool->lock);
+  pool->stats.cap_bytes = cap;
+  evict_to_cap(pool, 0);
+  pthread_mutex_unlock(&pool->lock);
+}
+
+/**
+ * \brief  release every idle buffer of a pool
+ */
+void buf_pool_trim(buf_pool_t *pool){
+  if(pool == NULL)
+    return;
+
+  pthread_mutex_lock(&pool->lock);
+  while(evict_one(pool) == 0)
+    ;
+  pthread_mutex_unlock(&pool->lock);
+}
+
+/**
+ * \brief  hits, misses, evictions and bytes of a pool
+ */
+void buf_pool_stats(buf_pool_t *pool, fpga_pool_stats_t *stats){
+  if(pool == NULL || stats == NULL)
+    return;
+
+  pthread_mutex_lock(&pool->lock);
+  *stats = pool->stats;
+  pthread_mutex_unlock(&pool->lock);
+}
+
+/**
+ * \brief  release the idle buffers and the pool. Buffers still in use are
+ *         not released, they are released by their owners.
+ */
+void buf_pool_destroy(buf_pool_t *pool){
+  if(pool == NULL)
+    return;
+
+  buf_pool_trim(pool);
+
+  pool_entry_t *e = pool->used;
+  while(e != NULL){
+    pool_entry_t *next = e->next;
+    free(e);
+    e = next;
+  }
+
+  pthread_mutex_destroy(&pool->lock);
+  free(pool);
+}
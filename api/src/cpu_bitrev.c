@@ -0,0 +1,149 @@
+//  Author: Arjun Ramaswami
+
+/*
+ * Bit reversal of the rows of single precision complex matrices, the i/o
+ * order of the bitreversed kernel variants. A row of N values is viewed as
+ * N / POINTS words of POINTS values, [k][p]. Value p of word k moves to
+ * [rev(p)][k], rev reversing the LOGPOINTS bits of p.
+ *
+ * Rows are permuted one at a time through a row sized buffer, on the stack
+ * up to ROW_MAX values, the words transposed by the SIMD tile kernels of
+ * cpu_transpose_block(). No copy of the matrices is made. If the buffer of
+ * a longer row cannot be allocated, rows are permuted by two passes of
+ * swaps: reversing all bits of an index moves rev(p) to the top but also
+ * reverses k, restored by reversing the low bits of every segment of
+ * N / POINTS.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "transpose_fpga.h"
+#include "cpu_transpose.h"
+#include "cpu_bitrev.h"
+
+// Longest row permuted through a stack buffer
+#define ROW_MAX 1024
+
+/**
+ * \brief  reverse the lowest bits of x
+ */
+static size_t rev_bits(size_t x, unsigned bits){
+  size_t r = 0;
+  for(unsigned b = 0; b < bits; b++){
+    r = (r << 1) | (x & 1);
+    x >>= 1;
+  }
+  return r;
+}
+
+/**
+ * \brief  log2 of N, -1 if N is not a power of 2 of at least 2^logpoints
+ */
+static int check_size(int N, int logpoints){
+  if(N <= 0 || (N & (N - 1)) != 0 || logpoints < 0){
+    return -1;
+  }
+
+  int logn = 0;
+  while((1 << logn) < N)
+    logn++;
+  return (logn < logpoints) ? -1 : logn;
+}
+
+/**
+ * \brief  swap values whose indices are the bit reversal of each other
+ */
+static void swap_rev(float2 *data, size_t n, unsigned bits){
+  for(size_t i = 0; i < n; i++){
+    size_t j = rev_bits(i, bits);
+    if(i < j){
+      float2 t = data[i];
+      data[i] = data[j];
+      data[j] = t;
+    }
+  }
+}
+
+/**
+ * \brief  bit reverse a row in place
+ * \param  tmp: row sized buffer, NULL to permute by swaps
+ */
+static void bitrev_row(float2 *row, unsigned logn, unsigned logpoints, float2 *tmp){
+  const size_t n = (size_t)1 << logn;
+  const size_t points = (size_t)1 << logpoints;
+  const size_t words = n >> logpoints;
+
+  if(tmp != NULL){
+    // tmp[p][k] = row[k][p], then rows of tmp to their reversed position
+    cpu_transpose_block(row, points, tmp, words, words, points);
+    for(size_t p = 0; p < points; p++){
+      memcpy(&row[rev_bits(p, logpoints) * words], &tmp[p * words], sizeof(float2) * words);
+    }
+  }
+  else{
+    swap_rev(row, n, logn);
+    for(size_t s = 0; s < points; s++){
+      swap_rev(&row[s * words], words, logn - logpoints);
+    }
+  }
+}
+
+/**
+ * \brief  bit reverse every row of a batch of matrices in place
+ * \param  data: pointer to rows * N values
+ * \param  N: length of a row, a power of 2 of at least 2^logpoints
+ * \param  rows: number of rows, batch * N for a batch of square matrices
+ * \param  logpoints: log of the values of a word, 3 for the 8-point variants
+ */
+void cpu_bitrev_rows(float2 *data, int N, size_t rows, int logpoints){
+  float2 row_buf[ROW_MAX];
+  int logn = check_size(N, logpoints);
+
+  if(data == NULL || logn < 0){
+    return;
+  }
+
+  float2 *tmp = (N <= ROW_MAX) ? row_buf : (float2 *)malloc(sizeof(float2) * N);
+
+  for(size_t r = 0; r < rows; r++){
+    bitrev_row(&data[r * N], logn, logpoints, tmp);
+  }
+
+  if(tmp != row_buf)
+    free(tmp);
+}
+
+/**
+ * \brief  out of place transpose of a batch of square matrices, the output
+ *         rows bit reversed as by cpu_bitrev_rows(). Row i = k * POINTS + p of
+ *         the input becomes column rev(p) * N / POINTS + k of the output, so
+ *         every p transposes the input rows strided by POINTS into a
+ *         contiguous range of output columns.
+ * \param  inp: pointer to batch * N * N input values
+ * \param  out: pointer to batch * N * N output values, must not overlap inp
+ * \param  N: length of the square matrix, a power of 2 of at least 2^logpoints
+ * \param  batch: number of matrices
+ * \param  logpoints: log of the values of a word
+ */
+void cpu_transpose_bitrev(const float2 *inp, float2 *out, int N, int batch, int logpoints){
+  int logn = check_size(N, logpoints);
+
+  if(inp == NULL || out == NULL || logn < 0){
+    return;
+  }
+
+  const size_t n = (size_t)N;
+  const size_t points = (size_t)1 << logpoints;
+  const size_t words = n >> logpoints;
+
+  for(size_t k = 0; k < (size_t)batch; k++){
+    const float2 *mat_in = &inp[k * n * n];
+    float2 *mat_out = &out[k * n * n];
+
+    for(size_t p = 0; p < points; p++){
+      cpu_transpose_block(&mat_in[p * n], points * n, &mat_out[rev_bits(p, logpoints) * words], n, words, n);
+    }
+  }
+}
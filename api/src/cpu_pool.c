@@ -0,0 +1,398 @@
+//  Author: Arjun Ramaswami
+
+/*
+ * Thread pool that transposes batches of matrices on the CPU. A batch is
+ * divided into tasks, each producing a stripe of rows of an output matrix.
+ * Tasks are partitioned among the workers in contiguous ranges, so that a
+ * worker owns whole matrices when the batch is larger than the pool. Idle
+ * workers steal tasks from the end of the ranges of the other workers.
+ *
+ * Workers are pinned to cores. Touching new memory in the contiguous ranges
+ * the workers own of an output of the same size places its pages on the NUMA
+ * node of the worker that writes them.
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+
+#include "transpose_fpga.h"
+#include "cpu_transpose.h"
+#include "cpu_pool.h"
+#include "helper.h"
+#include "mtrans_backend.h"
+
+// Approximate number of complex values transposed per task
+#define TASK_POINTS (1 << 15)
+
+// Bytes zeroed per task of a first touch
+#define TOUCH_BYTES (sizeof(float2) * TASK_POINTS)
+
+typedef enum { JOB_TRANSPOSE, JOB_TOUCH } job_type;
+
+typedef struct {
+  job_type type;
+  const float2 *inp;
+  float2 *out;
+  size_t N;
+  size_t stripe;     // rows of the output per task
+  size_t stripes;    // tasks per matrix
+  size_t bytes;      // of out to touch
+} job_t;
+
+// Range of tasks [head, tail) owned by a worker
+typedef struct {
+  pthread_mutex_t lock;
+  size_t head;
+  size_t tail;
+} worker_t;
+
+typedef struct {
+  cpu_pool_t *pool;
+  int id;
+} worker_arg_t;
+
+struct cpu_pool {
+  int nthreads;
+  pthread_t *threads;
+  worker_t *workers;
+  worker_arg_t *args;
+
+  pthread_mutex_t lock;
+  pthread_cond_t start_cv, done_cv;
+  unsigned long generation;
+  int active;
+  int shutdown;
+
+  job_t job;
+};
+
+/**
+ * \brief  process task t of the current job
+ */
+static void run_task(const job_t *job, size_t t){
+  if(job->type == JOB_TOUCH){
+    const size_t off = t * TOUCH_BYTES;
+    const size_t len = (off + TOUCH_BYTES) > job->bytes ? (job->bytes - off) : TOUCH_BYTES;
+    memset((char *)job->out + off, 0, len);
+    return;
+  }
+
+  const size_t k = t / job->stripes;
+  const size_t r0 = (t % job->stripes) * job->stripe;
+  const size_t rows = (r0 + job->stripe) > job->N ? (job->N - r0) : job->stripe;
+  const size_t mat_sz = job->N * job->N;
+
+  float2 *out = &job->out[(k * mat_sz) + (r0 * job->N)];
+
+  // rows [r0, r0 + rows) of the output are columns of the input
+  const float2 *inp = &job->inp[(k * mat_sz) + r0];
+  cpu_transpose_block(inp, job->N, out, job->N, job->N, rows);
+}
+
+/**
+ * \brief  take the next task from the front of the worker's own range
+ * \retval 1 if a task was taken
+ */
+static int pop_task(worker_t *w, size_t *t){
+  int found = 0;
+  pthread_mutex_lock(&w->lock);
+  if(w->head < w->tail){
+    *t = w->head++;
+    found = 1;
+  }
+  pthread_mutex_unlock(&w->lock);
+  return found;
+}
+
+/**
+ * \brief  take a task from the end of the range of another worker
+ * \retval 1 if a task was stolen
+ */
+static int steal_task(cpu_pool_t *pool, int id, size_t *t){
+  for(int i = 1; i < pool->nthreads; i++){
+    worker_t *victim = &pool->workers[(id + i) % pool->nthreads];
+    int found = 0;
+
+    pthread_mutex_lock(&victim->lock);
+    if(victim->head < victim->tail){
+      *t = --victim->tail;
+      found = 1;
+    }
+    pthread_mutex_unlock(&victim->lock);
+
+    if(found)
+      return 1;
+  }
+  return 0;
+}
+
+/**
+ * \brief  pin the calling thread to a core, workers wrap around the cores
+ */
+static void pin_worker(int id){
+  long ncores = sysconf(_SC_NPROCESSORS_ONLN);
+  if(ncores <= 0)
+    return;
+
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(id % ncores, &set);
+  pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &set);
+}
+
+static void* worker_main(void *arg){
+  worker_arg_t *warg = (worker_arg_t *)arg;
+  cpu_pool_t *pool = warg->pool;
+  unsigned long seen = 0;
+
+  pin_worker(warg->id);
+
+  while(1){
+    pthread_mutex_lock(&pool->lock);
+    while(pool->generation == seen && !pool->shutdown){
+      pthread_cond_wait(&pool->start_cv, &pool->lock);
+    }
+    if(pool->shutdown){
+      pthread_mutex_unlock(&pool->lock);
+      break;
+    }
+    seen = pool->generation;
+    job_t job = pool->job;
+    pthread_mutex_unlock(&pool->lock);
+
+    size_t t;
+    while(pop_task(&pool->workers[warg->id], &t) || steal_task(pool, warg->id, &t)){
+      run_task(&job, t);
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    if(--pool->active == 0){
+      pthread_cond_signal(&pool->done_cv);
+    }
+    pthread_mutex_unlock(&pool->lock);
+  }
+  return NULL;
+}
+
+/**
+ * \brief  partition the tasks of a job among the workers and wait until all
+ *         tasks are processed
+ */
+static void run_job(cpu_pool_t *pool, job_t job, size_t ntasks){
+
+  pthread_mutex_lock(&pool->lock);
+  pool->job = job;
+  for(int i = 0; i < pool->nthreads; i++){
+    worker_t *w = &pool->workers[i];
+    pthread_mutex_lock(&w->lock);
+    w->head = (ntasks * i) / pool->nthreads;
+    w->tail = (ntasks * (i + 1)) / pool->nthreads;
+    pthread_mutex_unlock(&w->lock);
+  }
+  pool->active = pool->nthreads;
+  pool->generation++;
+  pthread_cond_broadcast(&pool->start_cv);
+
+  while(pool->active > 0){
+    pthread_cond_wait(&pool->done_cv, &pool->lock);
+  }
+  pthread_mutex_unlock(&pool->lock);
+}
+
+/**
+ * \brief  divide batch N x N matrices into tasks of output stripes
+ */
+static size_t make_job(job_t *job, job_type type, const float2 *inp, float2 *out, int N, int batch){
+  size_t stripe = TASK_POINTS / N;
+  // multiples of 8 rows to transpose complete tiles
+  stripe = (stripe < 8) ? 8 : (stripe & ~(size_t)7);
+  if(stripe > (size_t)N)
+    stripe = N;
+
+  job->type = type;
+  job->inp = inp;
+  job->out = out;
+  job->N = N;
+  job->stripe = stripe;
+  job->stripes = (N + stripe - 1) / stripe;
+
+  return job->stripes * batch;
+}
+
+/**
+ * \brief  create a pool of worker threads
+ * \param  nthreads : number of workers, every online core if 0 or less
+ * \retval pool or NULL if the workers could not be created
+ */
+cpu_pool_t* cpu_pool_create(int nthreads){
+
+  if(nthreads <= 0){
+    long ncores = sysconf(_SC_NPROCESSORS_ONLN);
+    nthreads = (ncores > 0) ? (int)ncores : 1;
+  }
+
+  cpu_pool_t *pool = (cpu_pool_t *)calloc(1, sizeof(cpu_pool_t));
+  if(pool == NULL)
+    return NULL;
+
+  pool->nthreads = nthreads;
+  pool->threads = (pthread_t *)calloc(nthreads, sizeof(pthread_t));
+  pool->workers = (worker_t *)calloc(nthreads, sizeof(worker_t));
+  pool->args = (worker_arg_t *)calloc(nthreads, sizeof(worker_arg_t));
+  if(pool->threads == NULL || pool->workers == NULL || pool->args == NULL){
+    free(pool->threads);
+    free(pool->workers);
+    free(pool->args);
+    free(pool);
+    return NULL;
+  }
+
+  pthread_mutex_init(&pool->lock, NULL);
+  pthread_cond_init(&pool->start_cv, NULL);
+  pthread_cond_init(&pool->done_cv, NULL);
+
+  for(int i = 0; i < nthreads; i++){
+    pthread_mutex_init(&pool->workers[i].lock, NULL);
+    pool->args[i].pool = pool;
+    pool->args[i].id = i;
+  }
+
+  for(int i = 0; i < nthreads; i++){
+    if(pthread_create(&pool->threads[i], NULL, worker_main, &pool->args[i]) != 0){
+      fprintf(stderr, "Failed to create worker thread %d\n", i);
+      pool->nthreads = i;
+      cpu_pool_destroy(pool);
+      return NULL;
+    }
+  }
+
+  return pool;
+}
+
+/**
+ * \brief  number of worker threads of a pool
+ */
+int cpu_pool_threads(cpu_pool_t *pool){
+  return (pool == NULL) ? 0 : pool->nthreads;
+}
+
+/**
+ * \brief  zero a new buffer in contiguous ranges per worker, as
+ *         cpu_pool_mTranspose partitions an output of the same size, so that
+ *         pages are allocated on the NUMA node of the worker writing them
+ * \param  pool : pool of workers
+ * \param  buf  : pointer to untouched memory
+ * \param  sz   : size in bytes
+ */
+void cpu_pool_first_touch(cpu_pool_t *pool, void *buf, size_t sz){
+  job_t job = {JOB_TOUCH, NULL, (float2 *)buf, 0, 0, 0, sz};
+
+  if(pool == NULL || buf == NULL || sz == 0)
+    return;
+
+  run_job(pool, job, (sz + TOUCH_BYTES - 1) / TOUCH_BYTES);
+}
+
+/**
+ * \brief  compute a batched complex single precision matrix transposition
+ *         using the workers of the pool
+ * \param  pool  : pool of workers
+ * \param  N     : length of the matrix
+ * \param  inp   : pointer to input matrices
+ * \param  out   : pointer to output matrices, must not overlap inp
+ * \param  batch : number of matrices
+ * \retval fpga_t : exec_t is the time taken in milliseconds, no pcie transfers
+ */
+fpga_t cpu_pool_mTranspose(cpu_pool_t *pool, int N, float2 *inp, float2 *out, int batch){
+  fpga_t cpu_time = {0.0, 0.0, 0.0, 0};
+  job_t job;
+
+  if(pool == NULL || inp == NULL || out == NULL || N <= 0 || batch <= 0){
+    return cpu_time;
+  }
+
+  size_t ntasks = make_job(&job, JOB_TRANSPOSE, inp, out, N, batch);
+
+  double start = getTimeinMilliSec();
+  run_job(pool, job, ntasks);
+  cpu_time.exec_t = getTimeinMilliSec() - start;
+
+  cpu_time.valid = 1;
+  return cpu_time;
+}
+
+/**
+ * \brief  stop the workers and release the pool
+ */
+void cpu_pool_destroy(cpu_pool_t *pool){
+  if(pool == NULL)
+    return;
+
+  pthread_mutex_lock(&pool->lock);
+  pool->shutdown = 1;
+  pthread_cond_broadcast(&pool->start_cv);
+  pthread_mutex_unlock(&pool->lock);
+
+  for(int i = 0; i < pool->nthreads; i++){
+    pthread_join(pool->threads[i], NULL);
+  }
+
+  for(int i = 0; i < pool->nthreads; i++){
+    pthread_mutex_destroy(&pool->workers[i].lock);
+  }
+  pthread_mutex_destroy(&pool->lock);
+  pthread_cond_destroy(&pool->start_cv);
+  pthread_cond_destroy(&pool->done_cv);
+
+  free(pool->threads);
+  free(pool->workers);
+  free(pool->args);
+  free(pool);
+}
+
+/*
+ * CPU backend. Memory the host pool creates for it is first touched by the
+ * workers on allocation, memory recycled by the pool keeps its pages.
+ */
+static cpu_pool_t *backend_pool = NULL;
+
+static int cpu_init(const mtrans_opts_t *opts){
+  if(opts && opts->bitreverse){
+    fprintf(stderr, "Bitreversed i/o not supported by the cpu backend\n");
+    return 1;
+  }
+  backend_pool = cpu_pool_create(opts ? opts->threads : 0);
+  return (backend_pool == NULL) ? 1 : 0;
+}
+
+static void* cpu_alloc(size_t sz){
+  int created = 0;
+  void *ptr = mtrans_host_acquire(sz, &created);
+
+  if(created)
+    cpu_pool_first_touch(backend_pool, ptr, sz);
+  return ptr;
+}
+
+static fpga_t cpu_transpose_batch(int N, float2 *inp, float2 *out, int batch){
+  return cpu_pool_mTranspose(backend_pool, N, inp, out, batch);
+}
+
+static void cpu_finalize(){
+  cpu_pool_destroy(backend_pool);
+  backend_pool = NULL;
+}
+
+const mtrans_backend_t cpu_backend = {
+  "cpu",
+  cpu_init,
+  cpu_alloc,
+  mtrans_host_free,
+  cpu_transpose_batch,
+  cpu_finalize
+};
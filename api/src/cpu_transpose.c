@@ -0,0 +1,270 @@
+//  Author: Arjun Ramaswami
+
+/*
+ * Cache-oblivious transposition of single precision complex matrices on the
+ * CPU. Matrices are recursively split along the larger dimension until a
+ * block fits into the L1 cache. Blocks are transposed in tiles of 8 x 8
+ * complex values, treating each float2 as a 64-bit lane. The tile kernel is
+ * selected at runtime from the instruction sets supported by the CPU.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define X86_SIMD
+#endif
+
+#include "transpose_fpga.h"
+#include "cpu_transpose.h"
+
+// Length of a tile transposed by a SIMD kernel
+#define TILE 8
+// Length of the largest block transposed without further recursion
+#define BLOCK 32
+
+typedef void (*tile_fn)(const float2 *src, size_t ld_src, float2 *dst, size_t ld_dst);
+
+static tile_fn tile_kernel = NULL;
+static const char *tile_isa = NULL;
+
+/**
+ * \brief  transpose a tile of 8 x 8 complex values
+ */
+static void tile_scalar(const float2 *src, size_t ld_src, float2 *dst, size_t ld_dst){
+  for(size_t i = 0; i < TILE; i++){
+    for(size_t j = 0; j < TILE; j++){
+      dst[(j * ld_dst) + i] = src[(i * ld_src) + j];
+    }
+  }
+}
+
+#ifdef X86_SIMD
+/**
+ * \brief  transpose 4 x 4 complex values, each complex value is a double lane
+ */
+__attribute__((target("avx2")))
+static inline void tile4_avx2(const float2 *src, size_t ld_src, float2 *dst, size_t ld_dst){
+  __m256d r0 = _mm256_loadu_pd((const double *)&src[0 * ld_src]);
+  __m256d r1 = _mm256_loadu_pd((const double *)&src[1 * ld_src]);
+  __m256d r2 = _mm256_loadu_pd((const double *)&src[2 * ld_src]);
+  __m256d r3 = _mm256_loadu_pd((const double *)&src[3 * ld_src]);
+
+  // interleave pairs of rows within 128-bit lanes
+  __m256d t0 = _mm256_unpacklo_pd(r0, r1);
+  __m256d t1 = _mm256_unpackhi_pd(r0, r1);
+  __m256d t2 = _mm256_unpacklo_pd(r2, r3);
+  __m256d t3 = _mm256_unpackhi_pd(r2, r3);
+
+  // exchange 128-bit lanes
+  _mm256_storeu_pd((double *)&dst[0 * ld_dst], _mm256_permute2f128_pd(t0, t2, 0x20));
+  _mm256_storeu_pd((double *)&dst[1 * ld_dst], _mm256_permute2f128_pd(t1, t3, 0x20));
+  _mm256_storeu_pd((double *)&dst[2 * ld_dst], _mm256_permute2f128_pd(t0, t2, 0x31));
+  _mm256_storeu_pd((double *)&dst[3 * ld_dst], _mm256_permute2f128_pd(t1, t3, 0x31));
+}
+
+/**
+ * \brief  transpose a tile of 8 x 8 complex values as four 4 x 4 quadrants
+ */
+__attribute__((target("avx2")))
+static void tile_avx2(const float2 *src, size_t ld_src, float2 *dst, size_t ld_dst){
+  tile4_avx2(src, ld_src, dst, ld_dst);
+  tile4_avx2(&src[4], ld_src, &dst[4 * ld_dst], ld_dst);
+  tile4_avx2(&src[4 * ld_src], ld_src, &dst[4], ld_dst);
+  tile4_avx2(&src[(4 * ld_src) + 4], ld_src, &dst[(4 * ld_dst) + 4], ld_dst);
+}
+
+/**
+ * \brief  transpose a tile of 8 x 8 complex values, a row per register
+ */
+__attribute__((target("avx512f")))
+static void tile_avx512(const float2 *src, size_t ld_src, float2 *dst, size_t ld_dst){
+  __m512d r[TILE], t[TILE], u[TILE];
+
+  for(size_t i = 0; i < TILE; i++){
+    r[i] = _mm512_loadu_pd((const double *)&src[i * ld_src]);
+  }
+
+  // interleave pairs of rows: {r0_0 r1_0, r0_2 r1_2, ..}, {r0_1 r1_1, ..}
+  for(size_t i = 0; i < TILE; i += 2){
+    t[i] = _mm512_unpacklo_pd(r[i], r[i + 1]);
+    t[i + 1] = _mm512_unpackhi_pd(r[i], r[i + 1]);
+  }
+
+  // gather even and odd 128-bit lanes of pairs of rows
+  for(size_t i = 0; i < TILE; i += 4){
+    u[i] = _mm512_shuffle_f64x2(t[i], t[i + 2], 0x88);
+    u[i + 1] = _mm512_shuffle_f64x2(t[i + 1], t[i + 3], 0x88);
+    u[i + 2] = _mm512_shuffle_f64x2(t[i], t[i + 2], 0xDD);
+    u[i + 3] = _mm512_shuffle_f64x2(t[i + 1], t[i + 3], 0xDD);
+  }
+
+  // combine upper and lower halves of the tile into columns
+  for(size_t i = 0; i < 4; i++){
+    _mm512_storeu_pd((double *)&dst[i * ld_dst], _mm512_shuffle_f64x2(u[i], u[i + 4], 0x88));
+    _mm512_storeu_pd((double *)&dst[(i + 4) * ld_dst], _mm512_shuffle_f64x2(u[i], u[i + 4], 0xDD));
+  }
+}
+#endif
+
+/**
+ * \brief  select the tile kernel based on the instruction sets of the CPU
+ */
+static void select_kernel(){
+  tile_kernel = tile_scalar;
+  tile_isa = "scalar";
+
+#ifdef X86_SIMD
+  __builtin_cpu_init();
+  if(__builtin_cpu_supports("avx512f")){
+    tile_kernel = tile_avx512;
+    tile_isa = "avx512";
+  }
+  else if(__builtin_cpu_supports("avx2")){
+    tile_kernel = tile_avx2;
+    tile_isa = "avx2";
+  }
+#endif
+}
+
+/**
+ * \brief  transpose a block that fits the cache using 8 x 8 tiles, remainders
+ *         are transposed element-wise
+ */
+static void transpose_leaf(const float2 *src, size_t ld_src, float2 *dst, size_t ld_dst, size_t rows, size_t cols){
+  const size_t rows_t = rows & ~(size_t)(TILE - 1);
+  const size_t cols_t = cols & ~(size_t)(TILE - 1);
+
+  for(size_t i = 0; i < rows_t; i += TILE){
+    for(size_t j = 0; j < cols_t; j += TILE){
+      tile_kernel(&src[(i * ld_src) + j], ld_src, &dst[(j * ld_dst) + i], ld_dst);
+    }
+    for(size_t ii = i; ii < i + TILE; ii++){
+      for(size_t j = cols_t; j < cols; j++){
+        dst[(j * ld_dst) + ii] = src[(ii * ld_src) + j];
+      }
+    }
+  }
+  for(size_t i = rows_t; i < rows; i++){
+    for(size_t j = 0; j < cols; j++){
+      dst[(j * ld_dst) + i] = src[(i * ld_src) + j];
+    }
+  }
+}
+
+/**
+ * \brief  recursively halve the larger dimension of the block until it fits
+ *         the cache. Split points are aligned to tiles.
+ */
+static void transpose_rec(const float2 *src, size_t ld_src, float2 *dst, size_t ld_dst, size_t rows, size_t cols){
+
+  if(rows <= BLOCK && cols <= BLOCK){
+    transpose_leaf(src, ld_src, dst, ld_dst, rows, cols);
+  }
+  else if(rows >= cols){
+    size_t half = (rows / 2) & ~(size_t)(TILE - 1);
+    transpose_rec(src, ld_src, dst, ld_dst, half, cols);
+    transpose_rec(&src[half * ld_src], ld_src, &dst[half], ld_dst, rows - half, cols);
+  }
+  else{
+    size_t half = (cols / 2) & ~(size_t)(TILE - 1);
+    transpose_rec(src, ld_src, dst, ld_dst, rows, half);
+    transpose_rec(&src[half], ld_src, &dst[half * ld_dst], ld_dst, rows, cols - half);
+  }
+}
+
+/**
+ * \brief  transpose a rows x cols block of a matrix into a cols x rows block
+ * \param  src: pointer to the first element of the source block
+ * \param  ld_src: number of elements between rows of the source
+ * \param  dst: pointer to the first element of the destination block
+ * \param  ld_dst: number of elements between rows of the destination
+ * \param  rows: number of rows of the source block
+ * \param  cols: number of columns of the source block
+ */
+void cpu_transpose_block(const float2 *src, size_t ld_src, float2 *dst, size_t ld_dst, size_t rows, size_t cols){
+  if(tile_kernel == NULL){
+    select_kernel();
+  }
+
+  if(src == NULL || dst == NULL || rows == 0 || cols == 0){
+    return;
+  }
+
+  transpose_rec(src, ld_src, dst, ld_dst, rows, cols);
+}
+
+/**
+ * \brief  out of place transpose of a batch of square matrices
+ * \param  inp: pointer to batch * N * N input values
+ * \param  out: pointer to batch * N * N output values, must not overlap inp
+ * \param  N: length of the square matrix
+ * \param  batch: number of matrices
+ */
+void cpu_transpose(const float2 *inp, float2 *out, int N, int batch){
+  const size_t mat_sz = (size_t)N * N;
+
+  for(size_t k = 0; k < (size_t)batch; k++){
+    cpu_transpose_block(&inp[k * mat_sz], N, &out[k * mat_sz], N, N, N);
+  }
+}
+
+/**
+ * \brief  in place transpose of a batch of square matrices. Pairs of blocks
+ *         mirrored along the diagonal are swapped through a block sized buffer
+ * \param  data: pointer to batch * N * N values
+ * \param  N: length of the square matrix
+ * \param  batch: number of matrices
+ */
+void cpu_transpose_inplace(float2 *data, int N, int batch){
+  const size_t n = (size_t)N;
+  float2 tmp[BLOCK * BLOCK];
+
+  if(tile_kernel == NULL){
+    select_kernel();
+  }
+
+  if(data == NULL || N <= 0){
+    return;
+  }
+
+  for(size_t k = 0; k < (size_t)batch; k++){
+    float2 *mat = &data[k * n * n];
+
+    for(size_t bi = 0; bi < n; bi += BLOCK){
+      const size_t rows = (n - bi) < BLOCK ? (n - bi) : BLOCK;
+
+      // diagonal block
+      float2 *diag = &mat[(bi * n) + bi];
+      transpose_leaf(diag, n, tmp, rows, rows, rows);
+      for(size_t i = 0; i < rows; i++){
+        memcpy(&diag[i * n], &tmp[i * rows], sizeof(float2) * rows);
+      }
+
+      // A = (bi, bj), C = (bj, bi): A <- C', C <- A'
+      for(size_t bj = bi + BLOCK; bj < n; bj += BLOCK){
+        const size_t cols = (n - bj) < BLOCK ? (n - bj) : BLOCK;
+        float2 *blk_a = &mat[(bi * n) + bj];
+        float2 *blk_c = &mat[(bj * n) + bi];
+
+        transpose_leaf(blk_a, n, tmp, rows, rows, cols);
+        transpose_leaf(blk_c, n, blk_a, n, cols, rows);
+        for(size_t i = 0; i < cols; i++){
+          memcpy(&blk_c[i * n], &tmp[i * rows], sizeof(float2) * rows);
+        }
+      }
+    }
+  }
+}
+
+/**
+ * \brief  name of the instruction set used to transpose tiles
+ */
+const char* cpu_transpose_isa(){
+  if(tile_kernel == NULL){
+    select_kernel();
+  }
+  return tile_isa;
+}
@@ -11,6 +11,9 @@
 #define _USE_MATH_DEFINES
 
 #include "transpose_fpga.h"
+#include "cpu_transpose.h"
+#include "cpu_bitrev.h"
+#include "mtrans_backend.h"
 
 /*
  * \brief  Fill matrix with index as data
@@ -18,8 +21,10 @@
  * \param  cpu_transpose_data: pointer to square matrix of size N * N that has the same data as the input matrix
  * \param  N: length of square matrix
  * \param  batch: number of iteration of square matrix of size N*N
+ * \param  logpoints: log of the points of a word permuted by the bitreversed
+ *         variants
  */
-void get_input_data(float2 *transpose_data, float2 *cpu_transpose_data, unsigned N, unsigned batch, bool bitreverse){
+void get_input_data(float2 *transpose_data, float2 *cpu_transpose_data, unsigned N, unsigned batch, bool bitreverse, int logpoints){
 
   // Else randomly generate values and write to a file 
   printf("Creating data \n");
@@ -32,44 +37,8 @@ void get_input_data(float2 *transpose_data, float2 *cpu_transpose_data, unsigned
   }
 
   if(bitreverse){
-    float2 *temp = (float2 *)malloc(sizeof(float2) * batch * N * N);
-
-    for(size_t i = 0; i < batch; i++){
-
-      for(size_t j = 0; j < N; j++){
-
-        size_t pos_in = (i * N * N) + (j * N);
-
-        for(size_t k = 0; k < (N / 8); k++){
-          size_t pos_out = pos_in + (k * 8);
-
-          temp[pos_in + k].x = transpose_data[pos_out + 0].x;
-          temp[pos_in + (4 * N / 8) + k].x = transpose_data[pos_out + 1].x;
-          temp[pos_in + (2 * N / 8) + k].x = transpose_data[pos_out + 2].x;
-          temp[pos_in + (6 * N / 8) + k].x = transpose_data[pos_out + 3].x;
-          temp[pos_in + (N / 8) + k].x = transpose_data[pos_out + 4].x;
-          temp[pos_in + (5 * N / 8) + k].x = transpose_data[pos_out + 5].x;
-          temp[pos_in + (3 * N / 8) + k].x = transpose_data[pos_out + 6].x;
-          temp[pos_in + (7 * N / 8) + k].x = transpose_data[pos_out + 7].x;
-
-          temp[pos_in + k].y = transpose_data[pos_out + 0].y;
-          temp[pos_in + (4 * N / 8) + k].y = transpose_data[pos_out + 1].y;
-          temp[pos_in + (2 * N / 8) + k].y = transpose_data[pos_out + 2].y;
-          temp[pos_in + (6 * N / 8) + k].y = transpose_data[pos_out + 3].y;
-          temp[pos_in + (N / 8) + k].y = transpose_data[pos_out + 4].y;
-          temp[pos_in + (5 * N / 8) + k].y = transpose_data[pos_out + 5].y;
-          temp[pos_in + (3 * N / 8) + k].y = transpose_data[pos_out + 6].y;
-          temp[pos_in + (7 * N / 8) + k].y = transpose_data[pos_out + 7].y;
-        }
-      }
-    }
-
-    for(size_t i = 0; i < batch * N * N; i++){
-      transpose_data[i].x = temp[i].x;
-      transpose_data[i].y = temp[i].y;
-    }
-    free(temp);
-  } // bitreverse out
+    cpu_bitrev_rows(transpose_data, N, (size_t)batch * N, logpoints);
+  }
 
   /* 
   for (size_t i = 0; i < batch * (N * N); i++) {
@@ -93,7 +62,18 @@ double getTimeinMilliSec(){
  * \brief compute matrix transpose in CPU to verify FPGA implementation
  */
 void cpu_mTranspose(float2 *verify_data, int N, unsigned batch){
-  float2 *temp = (float2 *)malloc(sizeof(float2) * batch * N * N);
+  cpu_transpose_inplace(verify_data, N, batch);
+}
+
+/*
+ * \brief naive matrix transpose in CPU, kept as baseline for benchmarks
+ * \retval 0 if transposed, 1 if the temporary buffer is not allocated
+ */
+int cpu_mTranspose_naive(float2 *verify_data, int N, unsigned batch){
+  float2 *temp = (float2 *)mtrans_host_alloc(sizeof(float2) * batch * N * N);
+  if(temp == NULL){
+    return 1;
+  }
 
   for(size_t k = 0; k < batch; k++){
     for(size_t i = 0; i < N; i++){
@@ -109,13 +89,96 @@ void cpu_mTranspose(float2 *verify_data, int N, unsigned batch){
     verify_data[i].y = temp[i].y;
   }
 
-  /*
-  for (size_t i = 0; i < batch * N * N; i++) {
-    printf(" %d : transpose[%d] = (%f, %f)\n", i, i, verify_data[i].x, verify_data[i].y);
+  mtrans_host_free(temp);
+  return 0;
+}
+
+/**
+ * \brief  compare the naive and the cache-blocked cpu transposition. Both
+ *         transpose in place iter times, therefore the data is restored after
+ * \param  data: pointer to batch of square matrices
+ * \param  N: length of square matrix
+ * \param  batch: number of batched transposes
+ * \param  iter: number of transposes to average
+ */
+void cpu_bench_mTranspose(float2 *data, int N, int batch, int iter){
+
+  double naive_t = getTimeinMilliSec();
+  for(int i = 0; i < iter; i++){
+    if(cpu_mTranspose_naive(data, N, batch)){
+      // data left as given, transposed i times so far
+      fprintf(stderr, "Failed to allocate naive transposition benchmark\n");
+      if(i % 2)
+        cpu_mTranspose(data, N, batch);
+      return;
+    }
+  }
+  naive_t = (getTimeinMilliSec() - naive_t) / iter;
+
+  double blocked_t = getTimeinMilliSec();
+  for(int i = 0; i < iter; i++){
+    cpu_mTranspose(data, N, batch);
+  }
+  blocked_t = (getTimeinMilliSec() - blocked_t) / iter;
+
+  // bytes read and written per transposition
+  double gbytes = 2.0 * N * N * batch * sizeof(float2) * 1e-9;
+
+  printf("\n------------------------------------------\n");
+  printf("CPU Matrix Transpose\n");
+  printf("--------------------------------------------\n");
+  printf("Instruction Set    = %s\n", cpu_transpose_isa());
+  printf("Naive              = %.2lfms (%.2lf GB/s)\n", naive_t, gbytes / (naive_t * 1e-3));
+  printf("Cache-Blocked      = %.2lfms (%.2lf GB/s)\n", blocked_t, gbytes / (blocked_t * 1e-3));
+  printf("Speedup            = %.2lfx\n", naive_t / blocked_t);
+}
+
+/**
+ * \brief  compare a transposition followed by a separate bit reversal of the
+ *         output rows with both fused in a single pass
+ * \param  data: pointer to batch of square matrices, unchanged
+ * \param  N: length of square matrix
+ * \param  batch: number of batched transposes
+ * \param  iter: number of transposes to average
+ * \param  logpoints: log of the points of a word
+ */
+void cpu_bench_bitrev(const float2 *data, int N, int batch, int iter, int logpoints){
+  size_t sz = sizeof(float2) * N * N * batch;
+  float2 *separate = (float2 *)mtrans_host_alloc(sz);
+  float2 *fused = (float2 *)mtrans_host_alloc(sz);
+  if(separate == NULL || fused == NULL){
+    fprintf(stderr, "Failed to allocate bit reversal benchmark\n");
+    mtrans_host_free(separate);
+    mtrans_host_free(fused);
+    return;
   }
-  */
 
-  free(temp);
+  double separate_t = getTimeinMilliSec();
+  for(int i = 0; i < iter; i++){
+    cpu_transpose(data, separate, N, batch);
+    cpu_bitrev_rows(separate, N, (size_t)batch * N, logpoints);
+  }
+  separate_t = (getTimeinMilliSec() - separate_t) / iter;
+
+  double fused_t = getTimeinMilliSec();
+  for(int i = 0; i < iter; i++){
+    cpu_transpose_bitrev(data, fused, N, batch, logpoints);
+  }
+  fused_t = (getTimeinMilliSec() - fused_t) / iter;
+
+  double gbytes = 2.0 * sz * 1e-9;
+  bool match = (memcmp(separate, fused, sz) == 0);
+
+  printf("\n------------------------------------------\n");
+  printf("CPU Transpose and Bit Reversal\n");
+  printf("--------------------------------------------\n");
+  printf("Separate Passes    = %.2lfms (%.2lf GB/s)\n", separate_t, gbytes / (separate_t * 1e-3));
+  printf("Fused              = %.2lfms (%.2lf GB/s)\n", fused_t, gbytes / (fused_t * 1e-3));
+  printf("Speedup            = %.2lfx\n", separate_t / fused_t);
+  printf("Outputs            = %s\n", match ? "match" : "DIFFER");
+
+  mtrans_host_free(separate);
+  mtrans_host_free(fused);
 }
 
 /**
@@ -124,49 +187,15 @@ void cpu_mTranspose(float2 *verify_data, int N, unsigned batch){
  * \param  cpu_out: pointer to cpu Matrix Transpose output
  * \param  N: length of square matrix
  * \param  batch: number of batched transposes
+ * \param  logpoints: log of the points of a word permuted by the bitreversed
+ *         variants
  */
-void verify_mTranspose(float2 *fpga_out, float2 *cpu_out, int N, int batch, bool bitreverse){
+void verify_mTranspose(float2 *fpga_out, float2 *cpu_out, int N, int batch, bool bitreverse, int logpoints){
   float mag_sum = 0, noise_sum = 0;
 
   if(bitreverse){
-    float2 *temp = (float2 *)malloc(sizeof(float2) * batch * N * N);
-
-    for(size_t i = 0; i < batch; i++){
-
-      for(size_t j = 0; j < N; j++){
-
-        size_t pos_in = (i * N * N) + (j * N);
-
-        for(size_t k = 0; k < (N / 8); k++){
-          size_t pos_out = pos_in + (k * 8);
-
-          temp[pos_in + k].x = fpga_out[pos_out + 0].x;
-          temp[pos_in + (4 * N / 8) + k].x = fpga_out[pos_out + 1].x;
-          temp[pos_in + (2 * N / 8) + k].x = fpga_out[pos_out + 2].x;
-          temp[pos_in + (6 * N / 8) + k].x = fpga_out[pos_out + 3].x;
-          temp[pos_in + (N / 8) + k].x = fpga_out[pos_out + 4].x;
-          temp[pos_in + (5 * N / 8) + k].x = fpga_out[pos_out + 5].x;
-          temp[pos_in + (3 * N / 8) + k].x = fpga_out[pos_out + 6].x;
-          temp[pos_in + (7 * N / 8) + k].x = fpga_out[pos_out + 7].x;
-
-          temp[pos_in + k].y = fpga_out[pos_out + 0].y;
-          temp[pos_in + (4 * N / 8) + k].y = fpga_out[pos_out + 1].y;
-          temp[pos_in + (2 * N / 8) + k].y = fpga_out[pos_out + 2].y;
-          temp[pos_in + (6 * N / 8) + k].y = fpga_out[pos_out + 3].y;
-          temp[pos_in + (N / 8) + k].y = fpga_out[pos_out + 4].y;
-          temp[pos_in + (5 * N / 8) + k].y = fpga_out[pos_out + 5].y;
-          temp[pos_in + (3 * N / 8) + k].y = fpga_out[pos_out + 6].y;
-          temp[pos_in + (7 * N / 8) + k].y = fpga_out[pos_out + 7].y;
-        }
-      }
-    }
-
-    for(size_t i = 0; i < batch * N * N; i++){
-      fpga_out[i].x = temp[i].x;
-      fpga_out[i].y = temp[i].y;
-    }
-    free(temp);
-  } // bitreverse out
+    cpu_bitrev_rows(fpga_out, N, (size_t)batch * N, logpoints);
+  }
 
   for (size_t i = 0; i < batch * N * N; i++){
     float magnitude = cpu_out[i].x * cpu_out[i].x + \
@@ -192,11 +221,12 @@ void verify_mTranspose(float2 *fpga_out, float2 *cpu_out, int N, int batch, bool
  * \param  path: path to bitstream
  * \param  isND: kernel implemented as ND range or single work item
  */
-void print_config(int N, int batch, int use_svm, char *path, int isND){
+void print_config(int N, int batch, int use_svm, char *path, int isND, const char *backend){
   printf("\n------------------------------------------\n");
   printf("Matrix Transpose Configuration: \n");
   printf("--------------------------------------------\n");
   printf("Type               = Single Precision Complex 2d Matrix Transpose\n");
+  printf("Backend            = %s \n", backend);
   printf("Points             = [%d x %d] \n", N, N);
   printf("# Batched Transposes  = %d \n", batch);
   printf("%s PCIe Transfer \n", use_svm ? "SVM based":"");
@@ -211,22 +241,244 @@ void print_config(int N, int batch, int use_svm, char *path, int isND){
  * \param  pcie write time
  * \param  n: length of square matrix
  * \param  batch: number of batched transpositions
+ * \param  elem_sz: bytes of a complex element, float2 or double2
  */
-void display_measures(double b_exec, double pcie_rd_t, double pcie_wr_t, int N, int batch){
+void display_measures(double b_exec, double pcie_rd_t, double pcie_wr_t, int N, int batch, size_t elem_sz){
 
   double exec = b_exec / batch;
   double gpoints_per_sec = (N * N  / (exec * 1e-3)) * 1e-9;
   double gBytes_per_sec = 0.0;
 
-  gBytes_per_sec =  gpoints_per_sec * 8; // bytes
+  gBytes_per_sec =  gpoints_per_sec * elem_sz; // bytes
 
   printf("\n------------------------------------------\n");
   printf("Average Measurements of Matrix Transpose\n");
   printf("--------------------------------------------\n");
   printf("Points             = [%d x %d]\n", N, N);
+  printf("Element            = %zu bytes\n", elem_sz);
   printf("PCIe Write         = %.2lfms\n", pcie_wr_t);
   printf("Batch Kernel Execution  = %.2lfms\n", b_exec);
   printf("Kernel Execution   = %.2lfms\n", exec);
-  printf("PCIe Write         = %.2lfms\n", pcie_rd_t);
+  printf("PCIe Read          = %.2lfms\n", pcie_rd_t);
   printf("Throughput         = %.2lf GB/s\n", gBytes_per_sec);
-}
\ No newline at end of file
+}
+
+/**
+ * \brief  print latency per call with and without a persistent plan
+ * \param  call_t: average latency of mTranspose() that sets up resources per call
+ * \param  plan_t: average latency of mTranspose_execute() on a persistent plan
+ * \param  iter: number of calls averaged
+ */
+void display_latency(double call_t, double plan_t, int iter){
+
+  printf("\n------------------------------------------\n");
+  printf("Average Latency per Call over %d calls\n", iter);
+  printf("--------------------------------------------\n");
+  printf("mTranspose         = %.2lfms\n", call_t);
+  printf("Persistent Plan    = %.2lfms\n", plan_t);
+  printf("Saved per Call     = %.2lfms\n", call_t - plan_t);
+}
+
+/**
+ * \brief  print the device timestamps of the commands of an execution and
+ *         its launch overhead apart from the pipeline
+ * \param  prof : profile returned by mTranspose_profile()
+ */
+void display_profile(const fpga_profile_t *prof){
+  const char *names[5] = {"PCIe Write", "Fetch", "Transpose", "Store", "PCIe Read"};
+  const fpga_event_times_t *times[5] = {&prof->write, &prof->fetch, &prof->transpose, &prof->store, &prof->read};
+
+  printf("\n------------------------------------------\n");
+  printf("Device Profile of the Last Execution (ms)\n");
+  printf("--------------------------------------------\n");
+  printf("%-12s %10s %10s %10s %10s %10s\n", "Command", "Queued", "Submit", "Start", "End", "Duration");
+  for(int i = 0; i < 5; i++){
+    const fpga_event_times_t *t = times[i];
+    printf("%-12s %10.4lf %10.4lf %10.4lf %10.4lf %10.4lf\n", names[i], t->queued, t->submit, t->start, t->end, t->end - t->start);
+  }
+  printf("Launch Overhead    = %.4lfms\n", prof->launch_t);
+  printf("Pipeline           = %.4lfms\n", prof->pipeline_t);
+}
+
+/**
+ * \brief  print the average time per call of blocking calls on a plan and of
+ *         requests submitted to it without waiting
+ * \param  plan_t  : blocking execution per call in milliseconds
+ * \param  async_t : wall time of the requests per request in milliseconds
+ * \param  iter    : number of requests in flight together
+ */
+void display_async(double plan_t, double async_t, int iter, int N, int batch){
+
+  double gbytes = 2.0 * N * N * batch * sizeof(float2) * 1e-9;
+
+  printf("\n------------------------------------------\n");
+  printf("Asynchronous Requests, %d in flight\n", iter);
+  printf("--------------------------------------------\n");
+  printf("Blocking per Call  = %.2lfms (%.2lf GB/s)\n", plan_t, gbytes / (plan_t * 1e-3));
+  printf("Async per Request  = %.2lfms (%.2lf GB/s)\n", async_t, gbytes / (async_t * 1e-3));
+  printf("Speedup            = %.2lfx\n", plan_t / async_t);
+}
+
+/**
+ * \brief  print the counters of a pool of buffers recycled across calls
+ * \param  name  : memory of the pool, e.g. host or device
+ * \param  stats : counters of the pool
+ */
+void display_pool(const char *name, const fpga_pool_stats_t *stats){
+
+  size_t acquires = stats->hits + stats->misses;
+
+  printf("%-6s Pool        = %zu hits, %zu misses (%.1lf%% hit), %zu evicted, peak %.2lf MB",
+    name, stats->hits, stats->misses, acquires ? (100.0 * stats->hits) / acquires : 0.0,
+    stats->evictions, stats->peak_bytes / (1024.0 * 1024.0));
+  if(stats->cap_bytes > 0)
+    printf(" of %.2lf MB", stats->cap_bytes / (1024.0 * 1024.0));
+  printf("\n");
+}
+
+/**
+ * \brief  print the throughput of a file of matrices transposed into another
+ * \param  file    : matrices and windows of the files
+ * \param  total_t : end-to-end time in milliseconds
+ */
+void display_file(const fpga_file_t *file, double total_t, int N){
+
+  double gbytes = (double)file->matrices * N * N * sizeof(float2) * 1e-9;
+
+  printf("\n------------------------------------------\n");
+  printf("Transposition of Files\n");
+  printf("--------------------------------------------\n");
+  printf("Matrices           = %zu\n", file->matrices);
+  printf("Windows            = %zu of %zu matrices\n", file->windows, file->window);
+  printf("Total Time         = %.2lfms\n", total_t);
+  printf("Throughput         = %.2lf GB/s of each file\n", gbytes / (total_t * 1e-3));
+}
+
+/**
+ * \brief  print the batching achieved by coalescing concurrent requests and
+ *         their throughput compared with a launch per matrix
+ * \param  stats    : metrics of the coalescer
+ * \param  single_t : latency of a launch of a single matrix in milliseconds
+ * \param  total_t  : wall time of every coalesced request in milliseconds
+ */
+void display_coalesce(const fpga_coalesce_stats_t *stats, double single_t, double total_t, int N){
+
+  double gbytes = 2.0 * N * N * sizeof(float2) * 1e-9;
+
+  printf("\n------------------------------------------\n");
+  printf("Coalesced Requests\n");
+  printf("--------------------------------------------\n");
+  printf("Requests           = %zu\n", stats->requests);
+  printf("Launches           = %zu, %zu of a full batch\n", stats->launches, stats->full);
+  printf("Batch per Launch   = %.2lf avg, %d max\n", stats->avg_batch, stats->max_batch);
+  printf("Queueing Delay     = %.3lfms avg, %.3lfms max\n", stats->avg_queue_t, stats->max_queue_t);
+  printf("Launch per Matrix  = %.2lf GB/s\n", gbytes / (single_t * 1e-3));
+  printf("Coalesced          = %.2lf GB/s\n", (stats->matrices * gbytes) / (total_t * 1e-3));
+}
+
+/**
+ * \brief  print the slice and timings of every FPGA of a batch spread by
+ *         mTranspose_multi() and the combined throughput
+ * \param  multi : slices and timings of every device
+ * \param  N     : length of the matrix
+ */
+void display_multi(const fpga_multi_t *multi, int N){
+
+  double mat_bytes = (double)N * N * sizeof(float2);
+  int total = 0;
+
+  printf("\n------------------------------------------\n");
+  printf("Measurements of Matrix Transpose across FPGAs\n");
+  printf("--------------------------------------------\n");
+  printf("%6s %8s %14s %14s %14s %12s\n", "Device", "Batch", "PCIe Write(ms)", "Exec(ms)", "PCIe Read(ms)", "GB/s");
+  for(int d = 0; d < multi->devices; d++){
+    const fpga_t *t = &multi->timing[d];
+    double gbytes = (t->exec_t > 0.0) ? (multi->batch[d] * mat_bytes * 1e-9) / (t->exec_t * 1e-3) : 0.0;
+
+    printf("%6d %8d %14.2lf %14.2lf %14.2lf %12.2lf\n", d, multi->batch[d], t->pcie_write_t, t->exec_t, t->pcie_read_t, gbytes);
+    total += multi->batch[d];
+  }
+  printf("Devices            = %d\n", multi->devices);
+  printf("Total Time         = %.2lfms\n", multi->total_t);
+  printf("Combined Throughput = %.2lf GB/s\n", (total * mat_bytes * 1e-9) / (multi->total_t * 1e-3));
+}
+
+/**
+ * \brief  print end-to-end throughput of serial and streamed transposition
+ * \param  serial_t: pcie write, kernel execution and pcie read in sequence
+ * \param  stream_t: end-to-end time of the streamed transposition
+ * \param  N: length of square matrix
+ * \param  batch: number of batched transpositions
+ * \param  chunk: number of matrices per streamed chunk
+ */
+void display_stream(double serial_t, double stream_t, int N, int batch, int chunk){
+
+  // bytes transferred to and from the device
+  double gbytes = 2.0 * N * N * batch * sizeof(float2) * 1e-9;
+
+  printf("\n------------------------------------------\n");
+  printf("End-to-End Measurements of Matrix Transpose\n");
+  printf("--------------------------------------------\n");
+  printf("Chunk              = %d matrices\n", chunk);
+  printf("Serial             = %.2lfms\n", serial_t);
+  printf("Streamed           = %.2lfms\n", stream_t);
+  printf("Serial Throughput  = %.2lf GB/s\n", gbytes / (serial_t * 1e-3));
+  printf("Stream Throughput  = %.2lf GB/s\n", gbytes / (stream_t * 1e-3));
+  printf("Speedup            = %.2lfx\n", serial_t / stream_t);
+}
+
+/**
+ * \brief  fill a batch of rows x cols matrices with the index as data
+ */
+void get_rect_data(float2 *inp, int rows, int cols, int batch){
+  size_t mat_sz = (size_t)rows * cols;
+
+  printf("Creating data \n");
+  for(size_t j = 0; j < (size_t)batch; j++){
+    for(size_t i = 0; i < mat_sz; i++){
+      inp[(j * mat_sz) + i].x = (float)i;
+      inp[(j * mat_sz) + i].y = (float)i;
+    }
+  }
+}
+
+/**
+ * \brief  verify the cols x rows transpositions of rows x cols matrices
+ */
+void verify_rect(float2 *inp, float2 *out, int rows, int cols, int batch){
+  size_t mat_sz = (size_t)rows * cols, errors = 0;
+
+  for(size_t k = 0; k < (size_t)batch; k++){
+    for(size_t i = 0; i < (size_t)rows; i++){
+      for(size_t j = 0; j < (size_t)cols; j++){
+        float2 a = inp[(k * mat_sz) + (i * cols) + j];
+        float2 b = out[(k * mat_sz) + (j * rows) + i];
+        if(a.x != b.x || a.y != b.y)
+          errors++;
+      }
+    }
+  }
+  printf("-> Mismatched points: %zu --> %s\n\n", errors, errors == 0 ? "PASSED" : "FAILED");
+}
+
+/**
+ * \brief  print time and tiling of a rectangular transposition
+ * \param  exec_t: end-to-end time in milliseconds
+ * \param  tiling: distribution of the points between FPGA and cpu
+ */
+void display_tiling(double exec_t, int rows, int cols, int N, int batch, fpga_tiling_t *tiling){
+  // bytes of the matrices read and written, excluding padding
+  double gbytes = 2.0 * tiling->points * sizeof(float2) * 1e-9;
+
+  printf("\n------------------------------------------\n");
+  printf("Measurements of Rectangular Matrix Transpose\n");
+  printf("--------------------------------------------\n");
+  printf("Points             = [%d x %d]\n", rows, cols);
+  printf("Tile               = [%d x %d]\n", N, N);
+  printf("Batch              = %d\n", batch);
+  printf("FPGA Points        = %zu\n", tiling->fpga_points);
+  printf("Padding            = %zu (%.2lf%%)\n", tiling->padded_points, tiling->fpga_points ? (100.0 * tiling->padded_points / tiling->fpga_points) : 0.0);
+  printf("CPU Points         = %zu (%.2lf%%)\n", tiling->cpu_points, 100.0 * tiling->cpu_points / tiling->points);
+  printf("End-to-End         = %.2lfms\n", exec_t);
+  printf("Throughput         = %.2lf GB/s\n", gbytes / (exec_t * 1e-3));
+}
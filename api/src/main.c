@@ -2,25 +2,418 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <math.h>
 #include <stdbool.h>
-#include "CL/opencl.h"
+#include <pthread.h>
 
 #include "argparse.h"
 #include "transpose_fpga.h"
 #include "helper.h"
+#include "mtrans_backend.h"
 
 static const char *const usage[] = {
     "bin/host [options]",
     NULL,
 };
 
+#ifdef USE_FPGA
+/**
+ * \brief  transpose rows x cols matrices on the FPGA in tiles of N x N,
+ *         streaming chunks of tiles
+ * \retval 0 if successful
+ */
+static int transpose_rect(int rows, int cols, int N, int batch, int chunk, int isND){
+  size_t sz = sizeof(float2) * rows * cols * batch;
+  float2 *inp = (float2 *)mtrans_host_alloc(sz);
+  float2 *out = (float2 *)mtrans_host_alloc(sz);
+  if(inp == NULL || out == NULL){
+    fprintf(stderr, "Failed to allocate rectangular matrices\n");
+    mtrans_host_free(inp);
+    mtrans_host_free(out);
+    return 1;
+  }
+
+  get_rect_data(inp, rows, cols, batch);
+
+  // a row of tiles per execution unless chunk given, bounding device memory
+  int tiles = (chunk > 0) ? chunk : ((cols + N - 1) / N);
+  fpga_plan_t *plan = mTranspose_plan(N, tiles, isND);
+  fpga_tiling_t tiling;
+
+  printf("Transposing %d x %d Matrix\n", rows, cols);
+  fpga_t timing = mTranspose_rect(plan, rows, cols, inp, out, batch, &tiling);
+  mTranspose_destroy(plan);
+
+  printf("\nChecking Correctness\n");
+  verify_rect(inp, out, rows, cols, batch);
+
+  if(timing.valid == 1){
+    display_tiling(timing.exec_t, rows, cols, N, batch, &tiling);
+  }
+
+  mtrans_host_free(inp);
+  mtrans_host_free(out);
+  return (timing.valid == 1) ? 0 : 1;
+}
+
+/**
+ * \brief  transpose matrices in place on the FPGA, a single device buffer
+ *         per batch. Every call transposes the output of the previous one.
+ * \retval 0 if successful
+ */
+static int transpose_inplace(int N, int batch, int use_svm, int isND, int iter){
+  size_t sz = sizeof(float2) * N * N * batch;
+  float2 *data = (float2 *)fpgaf_complex_malloc(sz, use_svm);
+  float2 *verify = (float2 *)mtrans_host_alloc(sz);
+  if(data == NULL || verify == NULL){
+    fprintf(stderr, "Failed to allocate %d matrices to transpose in place\n", batch);
+    fpga_complex_free(data);
+    mtrans_host_free(verify);
+    return 1;
+  }
+
+  get_input_data(data, verify, N, batch, false, 0);
+
+  fpga_plan_t *plan = mTranspose_plan_inplace(N, batch, isND);
+  fpga_t timing = {0.0, 0.0, 0.0, 0};
+
+  printf("Transposing Matrix in Place\n");
+  for(int i = 0; i < iter && plan != NULL; i++){
+    timing = mTranspose_execute_inplace(plan, data, batch);
+  }
+  mTranspose_destroy(plan);
+
+  printf("\nChecking Correctness\n");
+  if(iter % 2)
+    cpu_mTranspose(verify, N, batch);
+  verify_mTranspose(data, verify, N, batch, false, 0);
+
+  if(timing.valid == 1){
+    display_measures(timing.exec_t, timing.pcie_read_t, timing.pcie_write_t, N, batch, sizeof(float2));
+    printf("Largest Batch      = %d in place, %d with separate buffers\n", fpga_max_batch(N, 1), fpga_max_batch(N, 0));
+  }
+
+  fpga_complex_free(data);
+  mtrans_host_free(verify);
+  return (timing.valid == 1) ? 0 : 1;
+}
+
+/**
+ * \brief  transpose the matrices of a file into another on the FPGA,
+ *         streaming chunks of the mapped files
+ * \retval 0 if successful
+ */
+static int transpose_file(const char *in_path, const char *out_path, int N, int chunk, int isND){
+  fpga_plan_t *plan = mTranspose_plan(N, chunk, isND);
+  fpga_file_t file;
+
+  printf("Transposing %s into %s\n", in_path, out_path);
+  fpga_t timing = mTranspose_file(plan, in_path, out_path, &file);
+  mTranspose_destroy(plan);
+
+  if(timing.valid == 1){
+    display_file(&file, timing.exec_t, N);
+  }
+  return (timing.valid == 1) ? 0 : 1;
+}
+
+/**
+ * \brief  transpose matrices of an element type other than float2 on a
+ *         bitstream built with the same TYPE. Elements are filled with and
+ *         compared by the bytes of their index, valid for any type. Indices
+ *         wider than an element are checked in rounds, each filling a slice
+ *         of the bits of the index, so that every misplaced element differs
+ *         in some round.
+ * \param  type : double2, float, half or bf16
+ * \retval 0 if successful
+ */
+static int transpose_typed(const char *type, int N, int batch, int use_svm, int isND, int iter){
+  enum {TYPE_DOUBLE2, TYPE_FLOAT, TYPE_HALF, TYPE_BF16} kind;
+  size_t elem_sz;
+
+  if(strcmp(type, "double2") == 0){
+    kind = TYPE_DOUBLE2;
+    elem_sz = sizeof(double2);
+  }
+  else if(strcmp(type, "float") == 0){
+    kind = TYPE_FLOAT;
+    elem_sz = sizeof(float);
+  }
+  else if(strcmp(type, "half") == 0){
+    kind = TYPE_HALF;
+    elem_sz = sizeof(half_t);
+  }
+  else if(strcmp(type, "bf16") == 0){
+    kind = TYPE_BF16;
+    elem_sz = sizeof(bf16_t);
+  }
+  else{
+    fprintf(stderr, "Unknown element type %s\n", type);
+    return 1;
+  }
+
+  size_t mat_sz = (size_t)N * N;
+  size_t sz = elem_sz * mat_sz * batch;
+  unsigned char *inp = (unsigned char *)fpgaf_complex_malloc(sz, use_svm);
+  unsigned char *out = (unsigned char *)fpgaf_complex_malloc(sz, use_svm);
+  if(inp == NULL || out == NULL){
+    fprintf(stderr, "Failed to allocate %s matrices\n", type);
+    fpga_complex_free(inp);
+    fpga_complex_free(out);
+    return 1;
+  }
+
+  // bits of the largest index of the batch, sliced as wide as an element
+  const size_t points = mat_sz * batch;
+  const size_t slice = (elem_sz < sizeof(size_t)) ? (8 * elem_sz) : (8 * sizeof(size_t));
+  size_t bits = 1;
+  while(bits < (8 * sizeof(size_t)) && ((points - 1) >> bits) != 0)
+    bits++;
+  const size_t rounds = (bits + slice - 1) / slice;
+
+  fpga_t timing = {0.0, 0.0, 0.0, 0};
+  fpga_plan_t *plan = NULL;
+  switch(kind){
+    case TYPE_DOUBLE2: plan = mTranspose_plan_d(N, batch, isND); break;
+    case TYPE_FLOAT: plan = mTranspose_plan_r(N, batch, isND); break;
+    case TYPE_HALF: plan = mTranspose_plan_h(N, batch, isND); break;
+    case TYPE_BF16: plan = mTranspose_plan_bf(N, batch, isND); break;
+  }
+
+  size_t errors = 0;
+  for(size_t r = 0; r < rounds && plan != NULL; r++){
+    printf("Creating data, round %zu of %zu\n", r + 1, rounds);
+    for(size_t i = 0; i < points; i++){
+      size_t idx = i >> (slice * r);
+      for(size_t b = 0; b < elem_sz; b++)
+        inp[(i * elem_sz) + b] = (unsigned char)(idx >> (8 * (b % sizeof(size_t))));
+    }
+
+    // timed over iter calls in the first round, once to check the others
+    printf("Transposing Matrix\n");
+    for(int i = 0; i < ((r == 0) ? iter : 1); i++){
+      fpga_t t = {0.0, 0.0, 0.0, 0};
+      switch(kind){
+        case TYPE_DOUBLE2: t = mTranspose_execute_d(plan, (double2 *)inp, (double2 *)out, batch); break;
+        case TYPE_FLOAT: t = mTranspose_execute_r(plan, (float *)inp, (float *)out, batch); break;
+        case TYPE_HALF: t = mTranspose_execute_h(plan, (half_t *)inp, (half_t *)out, batch); break;
+        case TYPE_BF16: t = mTranspose_execute_bf(plan, (bf16_t *)inp, (bf16_t *)out, batch); break;
+      }
+      if(r == 0)
+        timing = t;
+      else if(t.valid != 1)
+        timing.valid = 0;
+    }
+
+    printf("\nChecking Correctness\n");
+    for(size_t k = 0; k < (size_t)batch; k++){
+      for(size_t i = 0; i < (size_t)N; i++){
+        for(size_t j = 0; j < (size_t)N; j++){
+          const unsigned char *a = &inp[((k * mat_sz) + (i * N) + j) * elem_sz];
+          const unsigned char *b = &out[((k * mat_sz) + (j * N) + i) * elem_sz];
+          if(memcmp(a, b, elem_sz) != 0)
+            errors++;
+        }
+      }
+    }
+  }
+  mTranspose_destroy(plan);
+
+  printf("-> Mismatched points: %zu --> %s\n\n", errors, errors == 0 ? "PASSED" : "FAILED");
+
+  if(timing.valid == 1){
+    display_measures(timing.exec_t, timing.pcie_read_t, timing.pcie_write_t, N, batch, elem_sz);
+  }
+
+  fpga_complex_free(inp);
+  fpga_complex_free(out);
+  return (timing.valid == 1 && errors == 0) ? 0 : 1;
+}
+
+/**
+ * \brief  compare latency and throughput of svm memory, shared with the
+ *         kernels or pinned, with copies from aligned memory for batches of
+ *         powers of 2 up to 1024
+ * \retval 0 if successful
+ */
+static int bench_svm(int N, int isND, int iter){
+  const int max_batch = 1024;
+  size_t sz = sizeof(float2) * N * N * max_batch;
+
+  float2 *copy_inp = (float2 *)fpgaf_complex_malloc(sz, 0);
+  float2 *copy_out = (float2 *)fpgaf_complex_malloc(sz, 0);
+  float2 *svm_inp = (float2 *)fpgaf_complex_malloc(sz, 1);
+  float2 *svm_out = (float2 *)fpgaf_complex_malloc(sz, 1);
+  fpga_plan_t *plan = mTranspose_plan(N, max_batch, isND);
+
+  int status = 1;
+  if(copy_inp == NULL || copy_out == NULL || svm_inp == NULL || svm_out == NULL || plan == NULL){
+    fprintf(stderr, "Failed to allocate %d matrices for the svm benchmark\n", max_batch);
+    goto cleanup;
+  }
+
+  for(size_t i = 0; i < (size_t)N * N * max_batch; i++){
+    copy_inp[i].x = svm_inp[i].x = (float)i;
+    copy_inp[i].y = svm_inp[i].y = (float)(i % N);
+  }
+
+  printf("\nSVM memory %s compared with copies, average of %d calls\n", fpga_svm_shared() ? "shared with the kernels" : "pinned", iter);
+  printf("%8s %16s %12s %16s %12s %10s\n", "Batch", "Copy Lat.(ms)", "Copy GB/s", "SVM Lat.(ms)", "SVM GB/s", "Speedup");
+
+  for(int batch = 1; batch <= max_batch; batch *= 2){
+    double copy_t = getTimeinMilliSec();
+    for(int i = 0; i < iter; i++){
+      mTranspose_execute(plan, copy_inp, copy_out, batch);
+    }
+    copy_t = (getTimeinMilliSec() - copy_t) / iter;
+
+    double svm_t = getTimeinMilliSec();
+    for(int i = 0; i < iter; i++){
+      mTranspose_execute(plan, svm_inp, svm_out, batch);
+    }
+    svm_t = (getTimeinMilliSec() - svm_t) / iter;
+
+    if(memcmp(copy_out, svm_out, sizeof(float2) * N * N * batch) != 0){
+      fprintf(stderr, "Batch %d transposed in svm memory differs from the copy\n", batch);
+      goto cleanup;
+    }
+
+    // matrices read from and written to host memory
+    double gbytes = 2.0 * sizeof(float2) * N * N * batch * 1e-9;
+    printf("%8d %16.4lf %12.2lf %16.4lf %12.2lf %10.2lf\n", batch, copy_t, gbytes / (copy_t * 1e-3), svm_t, gbytes / (svm_t * 1e-3), copy_t / svm_t);
+  }
+  status = 0;
+
+cleanup:
+  mTranspose_destroy(plan);
+  fpga_complex_free(copy_inp);
+  fpga_complex_free(copy_out);
+  fpga_complex_free(svm_inp);
+  fpga_complex_free(svm_out);
+  return status;
+}
+
+// Caller of the coalescing benchmark, transposing its own matrix
+typedef struct {
+  fpga_coalescer_t *co;
+  int N, iter;
+  float2 *inp, *out;
+  int valid;
+} coalesce_caller_t;
+
+static void* coalesce_caller(void *arg){
+  coalesce_caller_t *c = (coalesce_caller_t *)arg;
+
+  c->valid = 1;
+  for(int i = 0; i < c->iter; i++){
+    fpga_t t = mTranspose_coalesce(c->co, c->inp, c->out, 1);
+    c->valid = c->valid && (t.valid == 1);
+  }
+  return NULL;
+}
+
+/**
+ * \brief  transpose a matrix per concurrent caller, iter times each, with
+ *         their requests coalesced into launches of upto batch matrices,
+ *         compared with a launch per matrix
+ * \param  callers   : number of threads submitting requests
+ * \param  budget_ms : longest a request waits for others
+ * \retval 0 if successful
+ */
+static int bench_coalesce(int N, int batch, int callers, double budget_ms, int isND, int iter){
+  const size_t mat_sz = (size_t)N * N;
+  float2 *inp = (float2 *)mtrans_host_alloc(sizeof(float2) * mat_sz * callers);
+  float2 *out = (float2 *)mtrans_host_alloc(sizeof(float2) * mat_sz * callers);
+  float2 *verify = (float2 *)mtrans_host_alloc(sizeof(float2) * mat_sz * callers);
+  coalesce_caller_t *caller = (coalesce_caller_t *)calloc(callers, sizeof(coalesce_caller_t));
+  pthread_t *thread = (pthread_t *)calloc(callers, sizeof(pthread_t));
+  fpga_plan_t *plan = mTranspose_plan(N, 1, isND);
+  fpga_coalescer_t *co = NULL;
+
+  int status = 1, started = 0;
+  if(inp == NULL || out == NULL || verify == NULL || caller == NULL || thread == NULL || plan == NULL){
+    fprintf(stderr, "Failed to setup %d callers for the coalescing benchmark\n", callers);
+    goto cleanup;
+  }
+
+  for(size_t i = 0; i < mat_sz * callers; i++){
+    inp[i].x = (float)i;
+    inp[i].y = (float)(i / mat_sz);
+  }
+
+  // a launch per matrix
+  double single_t = getTimeinMilliSec();
+  for(int i = 0; i < iter; i++){
+    mTranspose_execute(plan, inp, out, 1);
+  }
+  single_t = (getTimeinMilliSec() - single_t) / iter;
+
+  // released first, a persistent bitstream serves a single plan at a time
+  mTranspose_destroy(plan);
+  plan = NULL;
+
+  co = mTranspose_coalescer(N, batch, budget_ms, isND);
+  if(co == NULL){
+    fprintf(stderr, "Failed to setup %d callers for the coalescing benchmark\n", callers);
+    goto cleanup;
+  }
+
+  printf("Transposing a Matrix per Caller, %d callers\n", callers);
+  double total_t = getTimeinMilliSec();
+  for(started = 0; started < callers; started++){
+    caller[started] = (coalesce_caller_t){co, N, iter, &inp[started * mat_sz], &out[started * mat_sz], 0};
+    if(pthread_create(&thread[started], NULL, coalesce_caller, &caller[started]) != 0)
+      break;
+  }
+  for(int c = 0; c < started; c++){
+    pthread_join(thread[c], NULL);
+  }
+  total_t = getTimeinMilliSec() - total_t;
+
+  int valid = (started == callers);
+  for(int c = 0; c < started; c++){
+    valid = valid && caller[c].valid;
+  }
+
+  printf("\nChecking Correctness\n");
+  memcpy(verify, inp, sizeof(float2) * mat_sz * callers);
+  cpu_mTranspose(verify, N, callers);
+  verify_mTranspose(out, verify, N, callers, false, 0);
+
+  fpga_coalesce_stats_t stats;
+  mTranspose_coalesce_stats(co, &stats);
+  if(valid){
+    display_coalesce(&stats, single_t, total_t, N);
+    status = 0;
+  }
+
+cleanup:
+  mTranspose_coalescer_destroy(co);
+  mTranspose_destroy(plan);
+  mtrans_host_free(inp);
+  mtrans_host_free(out);
+  mtrans_host_free(verify);
+  free(caller);
+  free(thread);
+  return status;
+}
+#endif
+
 int main(int argc, const char **argv) {
 
-  int N = 64, batch = 0, isND = 0;
-  char *path;
-  int use_svm = 0, use_emulator = 0;
+  int N = 64, batch = 0, isND = 0, iter = 1, chunk = 0, threads = 0;
+  int rows = 0, cols = 0, callers = 0, pool_mb = 0;
+  float budget = 1.0f;
+  char *path = NULL;
+  const char *backend_name = "fpga";
+  const char *type = "float2";
+  const char *in_path = NULL, *out_path = NULL;
+  int use_svm = 0, use_emulator = 0, cpu_bench = 0, multi = 0, svm_bench = 0, async = 0;
+  int inplace = 0;
   bool bitreverse = false;
+  int logpoints = 3;  // points of a word of the bitreversed variants, 8 unless
+                      // the bitstream reports otherwise, as the sim models
 
   const char *platform = "Intel(R) FPGA";
 
@@ -31,9 +424,26 @@ int main(int argc, const char **argv) {
     OPT_GROUP("Basic Options"),
     OPT_INTEGER('n',"n", &N, "Length of Square Matrix"),
     OPT_INTEGER('b',"b", &batch, "Number of batched executions"),
-    OPT_BOOLEAN('v',"svm", &use_svm, "Use SVM"),
+    OPT_BOOLEAN('v',"svm", &use_svm, "Use SVM, shared with the kernels or pinned"),
     OPT_STRING('p', "path", &path, "Path to bitstream"),
     OPT_BOOLEAN('r', "bitreverse", &bitreverse, "Bitreverse i/o"),
+    OPT_INTEGER('i',"iter", &iter, "Number of calls to average latency per call"),
+    OPT_INTEGER('s',"stream", &chunk, "Stream batch in chunks of given size"),
+    OPT_BOOLEAN('c', "cpu", &cpu_bench, "Benchmark cpu transposition"),
+    OPT_STRING('k', "backend", &backend_name, "Backend: fpga, cpu or sim"),
+    OPT_INTEGER('t',"threads", &threads, "Number of threads of the cpu backend"),
+    OPT_STRING('e', "type", &type, "Element type of the bitstream: float2, double2, float, half or bf16"),
+    OPT_BOOLEAN('m', "multi", &multi, "Spread batch across every FPGA of the platform"),
+    OPT_BOOLEAN('a', "async", &async, "Submit iter requests in flight together"),
+    OPT_BOOLEAN(0, "svm-bench", &svm_bench, "Compare SVM with copies for batches 1 to 1024"),
+    OPT_BOOLEAN(0, "inplace", &inplace, "Transpose in place, a single device buffer per batch"),
+    OPT_INTEGER('q', "coalesce", &callers, "Callers of a matrix each, coalesced into launches of batch"),
+    OPT_FLOAT(0, "budget", &budget, "Milliseconds a coalesced request waits for others"),
+    OPT_INTEGER(0, "pool-mb", &pool_mb, "Cap of the host and device buffer pools in MB"),
+    OPT_STRING(0, "in", &in_path, "File of matrices to transpose into --out"),
+    OPT_STRING(0, "out", &out_path, "File of the transposed matrices of --in"),
+    OPT_INTEGER(0,"rows", &rows, "Rows of a rectangular matrix, tiled in N x N"),
+    OPT_INTEGER(0,"cols", &cols, "Columns of a rectangular matrix, tiled in N x N"),
     OPT_END(),
   };
 
@@ -42,45 +452,271 @@ int main(int argc, const char **argv) {
   argparse_describe(&argparse, "Computing Matrix Transpose using FPGA", "Dimension of the matrix is mandatory, default batchation is 1");
   argc = argparse_parse(&argparse, argc, argv);
 
-  print_config(N, batch, use_svm, path, isND);
+  if(iter < 1){
+    iter = 1;
+  }
+
+  const mtrans_backend_t *backend = mtrans_find_backend(backend_name);
+  if(backend == NULL){
+    fprintf(stderr, "Backend %s not available\n", backend_name);
+    return 1;
+  }
+  bool is_fpga = (strcmp(backend->name, "fpga") == 0);
+
+  print_config(N, batch, use_svm, path, isND, backend->name);
+
+  // buffers recycled across calls, capped if given
+  if(pool_mb > 0){
+    mtrans_host_pool_limit((size_t)pool_mb << 20);
+#ifdef USE_FPGA
+    fpga_pool_limit((size_t)pool_mb << 20);
+#endif
+  }
 
-  if(fpga_initialize(platform, path, use_svm, use_emulator)){
+  mtrans_opts_t opts = {platform, path, use_svm, use_emulator, isND, threads, bitreverse, inplace};
+  if(backend->init(&opts)){
     return 1;
   }
 
+#ifdef USE_FPGA
+  if(is_fpga && fpga_replicated_banks() > 0){
+    printf("Replicated bitstream: batch split between %d pipelines over %d banks\n", fpga_banks(), fpga_replicated_banks());
+  }
+  else if(is_fpga && fpga_banks() > 0){
+    printf("Banked bitstream: batch split between %d pipelines\n", fpga_banks());
+  }
+  if(is_fpga && fpga_persistent()){
+    printf("Persistent bitstream: kernels launched once, transpositions posted through a doorbell\n");
+  }
+  if(is_fpga && fpga_runtime_size()){
+    printf("Runtime sized bitstream: N up to %d\n", fpga_size());
+  }
+  if(is_fpga && fpga_points() > 0){
+    while((1 << logpoints) < fpga_points())
+      logpoints++;
+  }
+  if(is_fpga && fpga_size() > 0 && (fpga_runtime_size() ? (N > fpga_size()) : (N != fpga_size()))){
+    fprintf(stderr, "N = %d is not transposed by the bitstream of N %s %d\n", N, fpga_runtime_size() ? "up to" : "=", fpga_size());
+    backend->finalize();
+    return 1;
+  }
+#endif
+
+  if(strcmp(type, "float2") != 0){
+    int status = 1;
+#ifdef USE_FPGA
+    if(is_fpga)
+      status = transpose_typed(type, N, batch, use_svm, isND, iter);
+    else
+#endif
+      fprintf(stderr, "Element type %s requires the fpga backend\n", type);
+    backend->finalize();
+    return status;
+  }
+
+  if(svm_bench){
+    int status = 1;
+#ifdef USE_FPGA
+    if(is_fpga)
+      status = bench_svm(N, isND, iter);
+    else
+#endif
+      fprintf(stderr, "SVM benchmark requires the fpga backend\n");
+    backend->finalize();
+    return status;
+  }
+
+  if(inplace){
+    int status = 1;
+#ifdef USE_FPGA
+    if(is_fpga && batch > 0)
+      status = transpose_inplace(N, batch, use_svm, isND, iter);
+    else
+#endif
+      fprintf(stderr, "Transposing in place requires a batch and the fpga backend\n");
+    backend->finalize();
+    return status;
+  }
+
+  if(in_path != NULL || out_path != NULL){
+    int status = 1;
+#ifdef USE_FPGA
+    if(is_fpga && in_path != NULL && out_path != NULL)
+      status = transpose_file(in_path, out_path, N, (chunk > 0) ? chunk : 16, isND);
+    else
+#endif
+      fprintf(stderr, "Files require both --in and --out and the fpga backend\n");
+    backend->finalize();
+    return status;
+  }
+
+  if(callers > 0){
+    int status = 1;
+#ifdef USE_FPGA
+    if(is_fpga && batch > 0)
+      status = bench_coalesce(N, batch, callers, budget, isND, iter);
+    else
+#endif
+      fprintf(stderr, "Coalescing requires a batch and the fpga backend\n");
+    backend->finalize();
+    return status;
+  }
+
+  if(rows > 0 || cols > 0){
+    int status = 1;
+#ifdef USE_FPGA
+    if(is_fpga && rows > 0 && cols > 0)
+      status = transpose_rect(rows, cols, N, batch, chunk, isND);
+    else
+#endif
+      fprintf(stderr, "Rectangular matrices require both dimensions and the fpga backend\n");
+    backend->finalize();
+    return status;
+  }
+
   size_t inp_sz = sizeof(float2) * N * N * batch;
 
-  float2 *inp = (float2*)fpgaf_complex_malloc(inp_sz, use_svm);
-  float2 *verify = (float2*)fpgaf_complex_malloc(inp_sz, use_svm);
-  float2 *out = (float2*)fpgaf_complex_malloc(inp_sz, use_svm);
+  float2 *inp = (float2*)backend->alloc(inp_sz);
+  float2 *verify = (float2*)backend->alloc(inp_sz);
+  float2 *out = (float2*)backend->alloc(inp_sz);
+  if(inp == NULL || verify == NULL || out == NULL){
+    fprintf(stderr, "Failed to allocate %d matrices of %d x %d\n", batch, N, N);
+    backend->dealloc(inp);
+    backend->dealloc(verify);
+    backend->dealloc(out);
+    backend->finalize();
+    mtrans_host_trim();
+    return 1;
+  }
+
+  get_input_data(inp, verify, N, batch, bitreverse, logpoints);
+
+  double call_t = 0.0, plan_t = 0.0, async_t = 0.0;
+  fpga_t stream_timing = {0.0, 0.0, 0.0, 0};
+#ifdef USE_FPGA
+  fpga_t multi_timing = {0.0, 0.0, 0.0, 0};
+  fpga_profile_t profile = {.valid = 0};
+  fpga_multi_t multi_report;
+#endif
+
+#ifdef USE_FPGA
+  if(is_fpga){
+    // setup and release of fpga resources on every call
+    call_t = getTimeinMilliSec();
+    for(int i = 0; i < iter; i++){
+      mTranspose(N, inp, out, batch, use_svm, isND);
+    }
+    call_t = (getTimeinMilliSec() - call_t) / iter;
+
+    // fpga resources reused by every call
+    fpga_plan_t *plan = mTranspose_plan(N, batch, isND);
+    plan_t = getTimeinMilliSec();
+    for(int i = 0; i < iter && plan != NULL; i++){
+      mTranspose_execute(plan, inp, out, batch);
+    }
+    plan_t = (getTimeinMilliSec() - plan_t) / iter;
+    mTranspose_profile(plan, &profile);
+
+    // requests submitted without waiting, in flight together
+    if(async && plan != NULL){
+      fpga_request_t **reqs = (fpga_request_t **)calloc(iter, sizeof(fpga_request_t *));
+      async_t = getTimeinMilliSec();
+      for(int i = 0; i < iter && reqs != NULL; i++){
+        reqs[i] = mTranspose_submit(plan, inp, out, batch, NULL, NULL);
+      }
+      for(int i = 0; i < iter && reqs != NULL; i++){
+        mTranspose_wait(reqs[i]);
+        mTranspose_release(reqs[i]);
+      }
+      async_t = (getTimeinMilliSec() - async_t) / iter;
+      free(reqs);
+    }
+    mTranspose_destroy(plan);
 
-  get_input_data(inp, verify, N, batch, bitreverse);
+    // chunks overlap pcie transfers with kernel execution
+    if(chunk > 0){
+      fpga_plan_t *stream_plan = mTranspose_plan(N, chunk, isND);
+      for(int i = 0; i < iter && stream_plan != NULL; i++){
+        stream_timing = mTranspose_stream(stream_plan, inp, out, batch);
+      }
+      mTranspose_destroy(stream_plan);
+    }
+
+    // slices of the batch on every fpga of the platform
+    if(multi){
+      printf("Transposing Matrix on %d FPGAs\n", fpga_devices());
+      multi_timing = mTranspose_multi(N, inp, out, batch, isND, &multi_report);
+    }
+  }
+#endif
 
+  // the fpga backend keeps its plan, and the kernels of a persistent
+  // bitstream, until finalized, so after the plans compared above
   printf("Transposing Matrix\n");
-  timing = mTranspose(N, inp, out, batch, use_svm, isND);
+  for(int i = 0; i < iter; i++){
+    timing = backend->transpose(N, inp, out, batch);
+  }
+
+  if(cpu_bench){
+    cpu_bench_mTranspose(verify, N, batch, iter);
+    if(bitreverse)
+      cpu_bench_bitrev(verify, N, batch, iter, logpoints);
+  }
 
   printf("\nComputing Matrix Transposition\n");
   cpu_mTranspose(verify, N, batch);
 
   printf("\nChecking Correctness\n");
-  verify_mTranspose(out, verify, N, batch, bitreverse);
+  verify_mTranspose(out, verify, N, batch, bitreverse, logpoints);
 
-  // destroy data
-  fpga_final();
+  int status = 0;
+  if(timing.valid == 1 && timing.exec_t == 0.0){
+    fprintf(stderr, "Measurement invalid\n");
+    status = 1;
+  }
+  else if(timing.valid == 1){
+    display_measures(timing.exec_t, timing.pcie_read_t, timing.pcie_write_t, N, batch, sizeof(float2));
+    if(is_fpga){
+      display_latency(call_t, plan_t, iter);
+    }
+#ifdef USE_FPGA
+    if(profile.valid){
+      display_profile(&profile);
+    }
+#endif
+    if(async_t > 0.0){
+      display_async(plan_t, async_t, iter, N, batch);
+    }
+  }
 
-  if(timing.valid == 1){
+  if(stream_timing.valid == 1){
+    display_stream(timing.pcie_write_t + timing.exec_t + timing.pcie_read_t, stream_timing.exec_t, N, batch, chunk);
+  }
 
-    if(timing.exec_t == 0.0){
-      fprintf(stderr, "Measurement invalid\n");
-      return 1;
-    }
+#ifdef USE_FPGA
+  if(multi_timing.valid == 1){
+    display_multi(&multi_report, N);
+  }
+#endif
+
+  // svm memory is released before the device
+  backend->dealloc(inp);
+  backend->dealloc(verify);
+  backend->dealloc(out);
 
-    display_measures(timing.exec_t, timing.pcie_read_t, timing.pcie_write_t, N, batch);
+  fpga_pool_stats_t pool;
+  printf("\n");
+  mtrans_host_pool_stats(&pool);
+  display_pool("Host", &pool);
+#ifdef USE_FPGA
+  if(is_fpga){
+    fpga_pool_stats(&pool);
+    display_pool("Device", &pool);
   }
+#endif
 
-  free(inp);
-  free(verify);
-  free(out);
+  backend->finalize();
+  mtrans_host_trim();
 
-  return 0;
-}
\ No newline at end of file
+  return status;
+}
@@ -0,0 +1,115 @@
+//  Author: Arjun Ramaswami
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "mtrans_backend.h"
+#include "buf_pool.h"
+
+static const mtrans_backend_t *backends[] = {
+#ifdef USE_FPGA
+  &fpga_backend,
+#endif
+  &cpu_backend,
+  &sim_backend,
+  NULL
+};
+
+/**
+ * \brief  find a backend compiled into the host by its name
+ * \param  name: fpga, cpu or sim
+ * \retval backend or NULL if not found
+ */
+const mtrans_backend_t* mtrans_find_backend(const char *name){
+  if(name == NULL){
+    return NULL;
+  }
+
+  for(size_t i = 0; backends[i] != NULL; i++){
+    if(strcmp(backends[i]->name, name) == 0){
+      return backends[i];
+    }
+  }
+  return NULL;
+}
+
+/*
+ * Host buffers recycled by size across calls, e.g. the input and output of
+ * every call of a benchmark and the buffers of the simulated device
+ */
+static buf_pool_t *host_pool = NULL;
+static pthread_once_t host_pool_once = PTHREAD_ONCE_INIT;
+
+static void* host_buf_create(size_t sz, uint64_t key){
+  void *memptr = NULL;
+
+  if(posix_memalign(&memptr, 64, sz) != 0){
+    return NULL;
+  }
+  return memptr;
+}
+
+static void host_buf_destroy(void *buf, size_t sz, uint64_t key){
+  free(buf);
+}
+
+static void host_pool_init(){
+  host_pool = buf_pool_create(0, host_buf_create, host_buf_destroy);
+}
+
+/**
+ * \brief  allocate host memory aligned to 64 bytes, recycled from the host
+ *         pool if a buffer of the same size was released
+ * \param  sz: size in bytes
+ * \retval pointer to memory or NULL
+ */
+void* mtrans_host_alloc(size_t sz){
+  return mtrans_host_acquire(sz, NULL);
+}
+
+/**
+ * \brief  allocate host memory as mtrans_host_alloc()
+ * \param  created: if not NULL, set to 1 if the memory was created by the
+ *                  pool, not yet touched, 0 if recycled
+ */
+void* mtrans_host_acquire(size_t sz, int *created){
+  pthread_once(&host_pool_once, host_pool_init);
+  return buf_pool_acquire(host_pool, sz, 0, created);
+}
+
+/**
+ * \brief  return memory allocated using mtrans_host_alloc() to the host pool
+ */
+void mtrans_host_free(void *ptr){
+  if(ptr != NULL && buf_pool_release(host_pool, ptr) != 0)
+    free(ptr);
+}
+
+/**
+ * \brief  cap the bytes of host buffers in use and kept for reuse, 0 for no
+ *         limit. Allocations beyond it fail.
+ */
+void mtrans_host_pool_limit(size_t bytes){
+  pthread_once(&host_pool_once, host_pool_init);
+  buf_pool_limit(host_pool, bytes);
+}
+
+/**
+ * \brief  hits, misses and bytes of the host pool
+ */
+void mtrans_host_pool_stats(fpga_pool_stats_t *stats){
+  if(stats == NULL)
+    return;
+
+  memset(stats, 0, sizeof(fpga_pool_stats_t));
+  buf_pool_stats(host_pool, stats);
+}
+
+/**
+ * \brief  release the host buffers kept for reuse
+ */
+void mtrans_host_trim(){
+  buf_pool_trim(host_pool);
+}
@@ -0,0 +1,113 @@
+//  Author: Arjun Ramaswami
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "argparse.h"
+#include "transpose_fpga.h"
+#include "perf_model.h"
+
+static const char *const usage[] = {
+    "bin/perfmodel [options]",
+    NULL,
+};
+
+/**
+ * \brief  print the parameters of the model
+ */
+static void print_model_config(const perf_params_t *p, int batch){
+  printf("\n------------------------------------------\n");
+  printf("Matrix Transpose Performance Model: \n");
+  printf("--------------------------------------------\n");
+  printf("Points             = [%d x %d] \n", 1 << p->logn, 1 << p->logn);
+  printf("Points per cycle   = %d \n", 1 << p->logpoints);
+  printf("Element            = %u bytes \n", p->elem_sz);
+  printf("Banks              = %u \n", p->banks);
+  printf("Replicated         = %u pipelines \n", p->repl);
+  printf("Kernel Frequency   = %.1lf MHz \n", p->freq_mhz);
+  printf("Memory Frequency   = %.1lf MHz \n", p->mem_freq_mhz);
+  printf("Max Batch          = %d \n", batch);
+  printf("--------------------------------------------\n");
+}
+
+/**
+ * \brief  print predicted measures of a variant for batches of powers of 2,
+ *         times and throughput computed as in display_measures()
+ */
+static void display_model(const perf_variant_t *v, const perf_params_t *p, int max_batch){
+  const int N = 1 << p->logn;
+
+  printf("\nVariant: %s\n", v->name);
+  printf("%8s %14s %12s %12s %12s %12s %12s %12s %14s %12s %12s %12s\n",
+    "Batch", "Cycles", "F mem", "F full", "T empty", "T full", "S empty", "S mem",
+    "Batch Exec(ms)", "Exec(ms)", "Latency(ms)", "GB/s");
+
+  for(int batch = 1; batch <= max_batch; batch *= 2){
+    perf_result_t r = perf_model(v, p, batch);
+
+    double exec = r.exec_t / batch;
+    double gpoints_per_sec = (N * N / (exec * 1e-3)) * 1e-9;
+    double gBytes_per_sec = gpoints_per_sec * p->elem_sz;
+    double latency = r.first_cycles / (p->freq_mhz * 1e3);
+
+    printf("%8d %14lu %12lu %12lu %12lu %12lu %12lu %12lu %14.4lf %12.4lf %12.4lf %12.2lf\n",
+      batch, r.cycles, r.fetch_mem_stalls, r.fetch_full_stalls,
+      r.transpose_empty_stalls, r.transpose_full_stalls,
+      r.store_empty_stalls, r.store_mem_stalls,
+      r.exec_t, exec, latency, gBytes_per_sec);
+  }
+}
+
+int main(int argc, const char **argv) {
+
+  int logn = 6, logpoints = 3, banks = 1, batch = 64, depth = 0, elem_sz = 8, repl = 4;
+  float freq = 300.0f, mem_freq = 300.0f;
+  const char *name = "all";
+
+  struct argparse_option options[] = {
+    OPT_HELP(),
+    OPT_GROUP("Basic Options"),
+    OPT_INTEGER('n',"logn", &logn, "Log of length of the square matrix"),
+    OPT_INTEGER('p',"logpoints", &logpoints, "Log of points per cycle"),
+    OPT_INTEGER('k',"banks", &banks, "Number of DDR banks"),
+    OPT_INTEGER('r',"repl", &repl, "Pipelines of replicated variants"),
+    OPT_FLOAT('f',"freq", &freq, "Kernel frequency in MHz"),
+    OPT_FLOAT('m',"memfreq", &mem_freq, "Memory controller frequency in MHz"),
+    OPT_STRING('v', "variant", &name, "Kernel variant or all"),
+    OPT_INTEGER('b',"b", &batch, "Largest batch, modelled in powers of 2"),
+    OPT_INTEGER('d',"depth", &depth, "Channel depth, variant default if 0"),
+    OPT_INTEGER('e', "elem", &elem_sz, "Bytes of an element: 16 double2, 8 float2, 4 float, 2 half or bf16"),
+    OPT_END(),
+  };
+
+  struct argparse argparse;
+  argparse_init(&argparse, options, usage, 0);
+  argparse_describe(&argparse, "Predicting Matrix Transpose performance on FPGA", "Variants: diagonal, diagonal_opt, nd_banked, swi_banked, matrixTranspose, matrixTranspose_banked, matrixTranspose_repl, simple");
+  argc = argparse_parse(&argparse, argc, argv);
+
+  if(logn < logpoints || logpoints < 0 || banks < 1 || repl < 1 || batch < 1 || depth < 0 || elem_sz < 1 || freq <= 0.0f || mem_freq <= 0.0f){
+    fprintf(stderr, "Invalid model parameters\n");
+    return 1;
+  }
+
+  perf_params_t params = {logn, logpoints, banks, freq, mem_freq, depth, elem_sz, repl};
+  print_model_config(&params, batch);
+
+  if(strcmp(name, "all") == 0){
+    const perf_variant_t *v;
+    for(unsigned i = 0; (v = perf_variant(i)) != NULL; i++){
+      display_model(v, &params, batch);
+    }
+  }
+  else{
+    const perf_variant_t *v = perf_find_variant(name);
+    if(v == NULL){
+      fprintf(stderr, "Variant %s not modelled\n", name);
+      return 1;
+    }
+    display_model(v, &params, batch);
+  }
+
+  return 0;
+}
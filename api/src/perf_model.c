@@ -0,0 +1,288 @@
+//  Author: Arjun Ramaswami
+
+/*
+ * Cycle-approximate model of the fetch -> transpose -> store pipeline. Only
+ * the number of words in flight is tracked, a word being the POINTS
+ * elements moved through the channels in a cycle.
+ *
+ * Every kernel is described by how it buffers words:
+ *  - GROUP: words are accepted until a group is complete, then emitted, with
+ *    a number of groups buffered at the same time. ND range kernels with a
+ *    local buffer and a barrier are groups of N words, the single buffered
+ *    transpose of diagonal.cl is a group of a matrix held in a single slot.
+ *  - LOCKSTEP: reads a word and writes a word of the previous matrix in the
+ *    same step, stalling if either is blocked, as in matrixTranspose.cl.
+ *
+ * Memory supplies fetch and drains store at a rate limited by the bandwidth
+ * of the banks relative to the kernel frequency. Banked variants run a
+ * pipeline per bank on a slice of the batch, every bank serving the reads of
+ * a pipeline and the writes of another. Replicated variants run repl such
+ * pipelines sharing the bandwidth of all banks.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "transpose_fpga.h"
+#include "perf_model.h"
+
+#define SWI_STAGE {STAGE_GROUP, GROUP_WORD, 1}
+#define ND_STAGE {STAGE_GROUP, GROUP_WORKGROUP, 2}
+
+static const perf_variant_t variants[] = {
+  {"diagonal",        SWI_STAGE, {STAGE_GROUP, GROUP_MATRIX, 1}, SWI_STAGE, 8, 0},
+  {"diagonal_opt",    SWI_STAGE, {STAGE_LOCKSTEP, GROUP_MATRIX, 2}, SWI_STAGE, 8, 0},
+  {"nd_banked",       ND_STAGE,  {STAGE_GROUP, GROUP_MATRIX, 2}, ND_STAGE, 8, 0},
+  {"swi_banked",      ND_STAGE,  {STAGE_GROUP, GROUP_MATRIX, 1}, ND_STAGE, 8, 0},
+  {"matrixTranspose", SWI_STAGE, {STAGE_LOCKSTEP, GROUP_MATRIX, 2}, SWI_STAGE, 0, 0},
+  {"matrixTranspose_banked", SWI_STAGE, {STAGE_LOCKSTEP, GROUP_MATRIX, 2}, SWI_STAGE, 0, 1},
+  {"matrixTranspose_repl", SWI_STAGE, {STAGE_LOCKSTEP, GROUP_MATRIX, 2}, SWI_STAGE, 0, 0, 1},
+  {"simple",          SWI_STAGE, {STAGE_GROUP, GROUP_MATRIX, 1}, SWI_STAGE, 0, 0},
+};
+
+#define NUM_VARIANTS (sizeof(variants) / sizeof(variants[0]))
+
+// Words buffered in a GROUP stage
+typedef struct {
+  unsigned long size;  // words in a group
+  unsigned slots;
+  unsigned long in_cnt, out_cnt;
+  unsigned ready;      // complete groups not yet emitted
+} group_t;
+
+// Memory bandwidth available to a kernel
+typedef struct {
+  double rate;         // words per kernel cycle, at most 1
+  double credit;
+} mem_t;
+
+const perf_variant_t* perf_variant(unsigned i){
+  return (i < NUM_VARIANTS) ? &variants[i] : NULL;
+}
+
+/**
+ * \brief  find a kernel variant by its name
+ * \param  name: name of the kernel file without extension
+ * \retval variant or NULL if not modelled
+ */
+const perf_variant_t* perf_find_variant(const char *name){
+  if(name == NULL){
+    return NULL;
+  }
+
+  for(unsigned i = 0; i < NUM_VARIANTS; i++){
+    if(strcmp(variants[i].name, name) == 0){
+      return &variants[i];
+    }
+  }
+  return NULL;
+}
+
+static void group_init(group_t *g, const stage_desc_t *desc, unsigned long n, unsigned long depth){
+  memset(g, 0, sizeof(group_t));
+  g->slots = desc->slots;
+  switch(desc->group){
+    case GROUP_WORKGROUP: g->size = n; break;
+    case GROUP_MATRIX: g->size = depth; break;
+    default: g->size = 1; break;
+  }
+}
+
+static int group_can_accept(const group_t *g){
+  // a partially filled group holds a slot
+  return (g->in_cnt > 0) ? 1 : (g->ready < g->slots);
+}
+
+static void group_accept(group_t *g){
+  if(++g->in_cnt == g->size){
+    g->ready++;
+    g->in_cnt = 0;
+  }
+}
+
+static int group_can_emit(const group_t *g){
+  return g->ready > 0;
+}
+
+static void group_emit(group_t *g){
+  if(++g->out_cnt == g->size){
+    g->ready--;
+    g->out_cnt = 0;
+  }
+}
+
+static int mem_tick(mem_t *m){
+  // unused bandwidth is not saved beyond a word
+  if(m->credit < 1.0)
+    m->credit += m->rate;
+  return m->credit >= 1.0;
+}
+
+/**
+ * \brief  simulate the pipeline cycle by cycle for a batch
+ */
+static perf_result_t simulate(const perf_variant_t *v, const perf_params_t *p, unsigned long chan_depth, double rate, int batch){
+  perf_result_t r;
+  memset(&r, 0, sizeof(perf_result_t));
+
+  const unsigned long n = 1UL << p->logn;
+  const unsigned long depth = 1UL << (p->logn + p->logn - p->logpoints);
+  const unsigned long total = depth * batch;
+
+  group_t fetch, transpose, store;
+  group_init(&fetch, &v->fetch, n, depth);
+  group_init(&transpose, &v->transpose, n, depth);
+  group_init(&store, &v->store, n, depth);
+
+  mem_t mem_rd = {rate, 0.0}, mem_wr = {rate, 0.0};
+  unsigned long chanin = 0, chanout = 0;
+  unsigned long loaded = 0, taken = 0, received = 0, stored = 0, step = 0;
+
+  while(stored < total){
+    r.cycles++;
+
+    // store: drain to memory, then read chanoutTranspose
+    int wr_ok = mem_tick(&mem_wr);
+    if(group_can_emit(&store)){
+      if(wr_ok){
+        group_emit(&store);
+        mem_wr.credit -= 1.0;
+        if(++stored == depth)
+          r.first_cycles = r.cycles;
+      }
+      else{
+        r.store_mem_stalls++;
+      }
+    }
+    if(received < total && group_can_accept(&store)){
+      if(chanout > 0){
+        chanout--;
+        group_accept(&store);
+        received++;
+      }
+      else{
+        r.store_empty_stalls++;
+      }
+    }
+
+    // transpose
+    if(v->transpose.kind == STAGE_LOCKSTEP){
+      if(step < total + depth){
+        int need_in = (step < total), need_out = (step >= depth);
+        if(need_in && chanin == 0){
+          r.transpose_empty_stalls++;
+        }
+        else if(need_out && chanout == chan_depth){
+          r.transpose_full_stalls++;
+        }
+        else{
+          chanin -= need_in;
+          chanout += need_out;
+          step++;
+        }
+      }
+    }
+    else{
+      if(group_can_emit(&transpose)){
+        if(chanout < chan_depth){
+          group_emit(&transpose);
+          chanout++;
+        }
+        else{
+          r.transpose_full_stalls++;
+        }
+      }
+      if(taken < total && group_can_accept(&transpose)){
+        if(chanin > 0){
+          chanin--;
+          group_accept(&transpose);
+          taken++;
+        }
+        else{
+          r.transpose_empty_stalls++;
+        }
+      }
+    }
+
+    // fetch: write chaninTranspose, then load from memory
+    int rd_ok = mem_tick(&mem_rd);
+    if(group_can_emit(&fetch)){
+      if(chanin < chan_depth){
+        group_emit(&fetch);
+        chanin++;
+      }
+      else{
+        r.fetch_full_stalls++;
+      }
+    }
+    if(loaded < total && group_can_accept(&fetch)){
+      if(rd_ok){
+        group_accept(&fetch);
+        mem_rd.credit -= 1.0;
+        loaded++;
+      }
+      else{
+        r.fetch_mem_stalls++;
+      }
+    }
+  }
+
+  return r;
+}
+
+/**
+ * \brief  predict the execution of a batch of transpositions
+ * \param  variant: structure of the kernels
+ * \param  params: size of the matrix, banks and frequencies
+ * \param  batch: number of matrices
+ * \retval cycles and stalls, extrapolated from the steady state of a pipeline
+ *         of PERF_SIM_BATCH matrices for larger batches. All zero if invalid.
+ */
+perf_result_t perf_model(const perf_variant_t *variant, const perf_params_t *params, int batch){
+  perf_result_t r;
+  memset(&r, 0, sizeof(perf_result_t));
+
+  if(variant == NULL || params == NULL || batch <= 0 || params->logn < params->logpoints || params->banks == 0 || (variant->replicated && params->repl == 0) || params->elem_sz == 0 || params->freq_mhz <= 0.0 || params->mem_freq_mhz <= 0.0){
+    return r;
+  }
+
+  unsigned long chan_depth = params->chan_depth ? params->chan_depth : (variant->chan_depth ? variant->chan_depth : (1UL << params->logpoints));
+
+  // words per kernel cycle delivered by the banks
+  double word_bytes = (double)(1UL << params->logpoints) * params->elem_sz;
+  double rate = (params->banks * PERF_BUS_BYTES * params->mem_freq_mhz) / (word_bytes * params->freq_mhz);
+
+  // pipelines run concurrently, the slowest on the largest slice of the batch
+  if(variant->banked){
+    rate = (PERF_BUS_BYTES * params->mem_freq_mhz) / (2.0 * word_bytes * params->freq_mhz);
+    batch = (batch + params->banks - 1) / params->banks;
+  }
+  else if(variant->replicated){
+    rate = (params->banks * PERF_BUS_BYTES * params->mem_freq_mhz) / (2.0 * params->repl * word_bytes * params->freq_mhz);
+    batch = (batch + params->repl - 1) / params->repl;
+  }
+  rate = (rate > 1.0) ? 1.0 : rate;
+
+  if(batch <= PERF_SIM_BATCH){
+    r = simulate(variant, params, chan_depth, rate, batch);
+  }
+  else{
+    // every further matrix adds the difference of the last two
+    perf_result_t prev = simulate(variant, params, chan_depth, rate, PERF_SIM_BATCH - 1);
+    perf_result_t last = simulate(variant, params, chan_depth, rate, PERF_SIM_BATCH);
+    unsigned long more = batch - PERF_SIM_BATCH;
+
+    r = last;
+    r.cycles += more * (last.cycles - prev.cycles);
+    r.fetch_mem_stalls += more * (last.fetch_mem_stalls - prev.fetch_mem_stalls);
+    r.fetch_full_stalls += more * (last.fetch_full_stalls - prev.fetch_full_stalls);
+    r.transpose_empty_stalls += more * (last.transpose_empty_stalls - prev.transpose_empty_stalls);
+    r.transpose_full_stalls += more * (last.transpose_full_stalls - prev.transpose_full_stalls);
+    r.store_empty_stalls += more * (last.store_empty_stalls - prev.store_empty_stalls);
+    r.store_mem_stalls += more * (last.store_mem_stalls - prev.store_mem_stalls);
+  }
+
+  r.exec_t = r.cycles / (params->freq_mhz * 1e3);
+  return r;
+}
@@ -0,0 +1,283 @@
+//  Author: Arjun Ramaswami
+
+/*
+ * Software stand-in for the FPGA that models the fetch -> transpose -> store
+ * pipeline of matrixTranspose.cl. Each kernel is a stage that advances by at
+ * most one iteration per cycle, connected by POINTS-wide channels of fixed
+ * depth. A stage stalls when its input channel is empty or its output
+ * channel is full, as with blocking channel reads and writes on the FPGA.
+ *
+ * The transpose stage uses the same diagonal double-buffered algorithm as
+ * readBuf() and writeBuf() in diagonal_opt.cl. With bitreverse, fetch undoes
+ * the 8-point bit reversal of the input rows and store applies it to the
+ * output rows, as expected by the host for the bitreversed kernel variants.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "transpose_fpga.h"
+#include "sim_transpose.h"
+#include "mtrans_backend.h"
+#include "helper.h"
+
+#define LOGPOINTS 3
+#define POINTS (1 << LOGPOINTS)
+
+typedef struct {
+  float2 lane[SIM_CHANNEL_DEPTH][POINTS];
+  unsigned head;
+  unsigned count;
+} channel_t;
+
+typedef struct {
+  unsigned logn;
+  unsigned n;
+  unsigned depth;  // N * N / POINTS
+} geom_t;
+
+static bool chan_empty(const channel_t *ch){
+  return ch->count == 0;
+}
+
+static bool chan_full(const channel_t *ch){
+  return ch->count == SIM_CHANNEL_DEPTH;
+}
+
+static void chan_write(channel_t *ch, const float2 data[POINTS]){
+  unsigned tail = (ch->head + ch->count) % SIM_CHANNEL_DEPTH;
+  memcpy(ch->lane[tail], data, sizeof(float2) * POINTS);
+  ch->count++;
+}
+
+static void chan_read(channel_t *ch, float2 data[POINTS]){
+  memcpy(data, ch->lane[ch->head], sizeof(float2) * POINTS);
+  ch->head = (ch->head + 1) % SIM_CHANNEL_DEPTH;
+  ch->count--;
+}
+
+/**
+ * \brief  position of column c in a row permuted by the 8-point bit reversal
+ *         done in get_input_data(), i.e. [k][p] -> [rev(p)][k]
+ */
+static unsigned bitrev_pos(unsigned c, unsigned n){
+  static const unsigned rev3[POINTS] = {0, 4, 2, 6, 1, 5, 3, 7};
+  return (rev3[c & (POINTS - 1)] * (n / POINTS)) + (c >> LOGPOINTS);
+}
+
+/**
+ * \brief  column whose bit reversed position is j, inverse of bitrev_pos()
+ */
+static unsigned bitrev_col(unsigned j, unsigned n){
+  static const unsigned rev3[POINTS] = {0, 4, 2, 6, 1, 5, 3, 7};
+  return ((j % (n / POINTS)) << LOGPOINTS) + rev3[j / (n / POINTS)];
+}
+
+/**
+ * \brief  read a rotated column of the transposed matrix, see readBuf()
+ */
+static void read_buf(const geom_t *g, const float2 *buf, unsigned step, float2 data[POINTS]){
+  const unsigned logn = g->logn, n = g->n;
+  unsigned base = (step & (n / POINTS - 1)) << logn;
+  unsigned offset = (step >> logn) & ((n / POINTS) - 1);
+  float2 rotate_out[POINTS];
+
+  for(unsigned i = 0; i < POINTS; i++){
+    unsigned rot = ((POINTS + i - (step >> (logn - LOGPOINTS))) << (logn - LOGPOINTS)) & (n - 1);
+    unsigned row_rotate = base + offset + rot;
+    rotate_out[i] = buf[(row_rotate * POINTS) + i];
+  }
+
+  unsigned rot_out = (step >> (logn - LOGPOINTS)) & (POINTS - 1);
+  for(unsigned i = 0; i < POINTS; i++){
+    data[i] = rotate_out[(i + rot_out) & (POINTS - 1)];
+  }
+}
+
+/**
+ * \brief  write a rotated row into the buffer, see writeBuf()
+ */
+static void write_buf(const geom_t *g, const float2 data[POINTS], float2 *buf, unsigned step){
+  unsigned row = step & (g->depth - 1);
+  unsigned rot = (row >> (g->logn - LOGPOINTS)) & (POINTS - 1);
+
+  for(unsigned i = 0; i < POINTS; i++){
+    buf[(row * POINTS) + i] = data[((i + POINTS) - rot) & (POINTS - 1)];
+  }
+}
+
+/**
+ * \brief  simulate a batched transposition through the kernel pipeline
+ * \param  N: length of the matrix, power of 2 and at least POINTS
+ * \param  src: input matrices in simulated device memory
+ * \param  dest: output matrices in simulated device memory
+ * \param  batch: number of matrices
+ * \param  bitreverse: model the bitreversed i/o variants
+ * \retval cycles and stalls of the simulated pipeline, zero if invalid
+ */
+sim_stats_t sim_mTranspose(int N, const float2 *src, float2 *dest, int batch, bool bitreverse){
+  sim_stats_t stats = {0, 0, 0, 0};
+
+  if(src == NULL || dest == NULL || batch <= 0 || N < POINTS || (N & (N - 1)) != 0){
+    return stats;
+  }
+
+  geom_t g;
+  g.n = N;
+  g.logn = 0;
+  while((1u << g.logn) < g.n)
+    g.logn++;
+  g.depth = (g.n * g.n) / POINTS;
+
+  // double buffer of the transpose kernel
+  float2 *buf = (float2 *)calloc(2 * (size_t)g.depth * POINTS, sizeof(float2));
+  channel_t *chanin = (channel_t *)calloc(1, sizeof(channel_t));
+  channel_t *chanout = (channel_t *)calloc(1, sizeof(channel_t));
+  if(buf == NULL || chanin == NULL || chanout == NULL){
+    free(buf);
+    free(chanin);
+    free(chanout);
+    return stats;
+  }
+  float2 *bufA[2] = {buf, &buf[(size_t)g.depth * POINTS]};
+
+  const size_t total = (size_t)batch * g.depth;
+  size_t fetch_i = 0, step = 0, store_i = 0;
+  bool is_bufA = false;
+
+  while(store_i < total){
+    stats.cycles++;
+
+    // store: drain a word of the output channel
+    if(chan_empty(chanout)){
+      stats.store_stalls++;
+    }
+    else{
+      float2 data[POINTS];
+      chan_read(chanout, data);
+
+      size_t where = store_i * POINTS;
+      size_t row = where / g.n, col = where % g.n;
+      for(unsigned i = 0; i < POINTS; i++){
+        size_t c = bitreverse ? bitrev_col(col + i, g.n) : (col + i);
+        dest[(row * g.n) + c] = data[i];
+      }
+      store_i++;
+    }
+
+    // transpose: one step of the double buffered diagonal transposition
+    if(step < total + g.depth){
+      bool need_in = (step < total);
+      bool need_out = (step >= g.depth);
+
+      if((need_in && chan_empty(chanin)) || (need_out && chan_full(chanout))){
+        stats.transpose_stalls++;
+      }
+      else{
+        float2 data[POINTS], data_out[POINTS];
+        if(need_in){
+          chan_read(chanin, data);
+        }
+        else{
+          memset(data, 0, sizeof(data));
+        }
+
+        is_bufA = ((step & (g.depth - 1)) == 0) ? !is_bufA : is_bufA;
+
+        read_buf(&g, is_bufA ? bufA[1] : bufA[0], step, data_out);
+        write_buf(&g, data, is_bufA ? bufA[0] : bufA[1], step);
+
+        if(need_out){
+          chan_write(chanout, data_out);
+        }
+        step++;
+      }
+    }
+
+    // fetch: stream a word of the input into the channel
+    if(fetch_i < total){
+      if(chan_full(chanin)){
+        stats.fetch_stalls++;
+      }
+      else{
+        float2 data[POINTS];
+        size_t where = fetch_i * POINTS;
+        size_t row = where / g.n, col = where % g.n;
+        for(unsigned i = 0; i < POINTS; i++){
+          size_t c = bitreverse ? bitrev_pos(col + i, g.n) : (col + i);
+          data[i] = src[(row * g.n) + c];
+        }
+        chan_write(chanin, data);
+        fetch_i++;
+      }
+    }
+  }
+
+  free(buf);
+  free(chanin);
+  free(chanout);
+  return stats;
+}
+
+/*
+ * Simulator backend: device buffers are host memory, transfers are copies
+ */
+static bool sim_bitreverse = false;
+
+static int sim_init(const mtrans_opts_t *opts){
+  sim_bitreverse = (opts != NULL) && opts->bitreverse;
+  return 0;
+}
+
+/**
+ * \brief  transpose on the simulated device
+ * \retval fpga_t : pcie times are copies to and from simulated device memory,
+ *                  exec_t is the simulated cycles at SIM_FREQ_MHZ
+ */
+static fpga_t sim_transpose(int N, float2 *inp, float2 *out, int batch){
+  fpga_t sim_time = {0.0, 0.0, 0.0, 0};
+
+  if(inp == NULL || out == NULL || batch <= 0 || N <= 0){
+    return sim_time;
+  }
+
+  size_t buf_sz = sizeof(float2) * batch * N * N;
+  float2 *d_inData = (float2 *)mtrans_host_alloc(buf_sz);
+  float2 *d_outData = (float2 *)mtrans_host_alloc(buf_sz);
+  if(d_inData == NULL || d_outData == NULL){
+    mtrans_host_free(d_inData);
+    mtrans_host_free(d_outData);
+    return sim_time;
+  }
+
+  sim_time.pcie_write_t = getTimeinMilliSec();
+  memcpy(d_inData, inp, buf_sz);
+  sim_time.pcie_write_t = getTimeinMilliSec() - sim_time.pcie_write_t;
+
+  sim_stats_t stats = sim_mTranspose(N, d_inData, d_outData, batch, sim_bitreverse);
+  sim_time.exec_t = stats.cycles / (SIM_FREQ_MHZ * 1e3);
+
+  sim_time.pcie_read_t = getTimeinMilliSec();
+  memcpy(out, d_outData, buf_sz);
+  sim_time.pcie_read_t = getTimeinMilliSec() - sim_time.pcie_read_t;
+
+  mtrans_host_free(d_inData);
+  mtrans_host_free(d_outData);
+
+  sim_time.valid = (stats.cycles > 0) ? 1 : 0;
+  return sim_time;
+}
+
+static void sim_finalize(){
+  sim_bitreverse = false;
+}
+
+const mtrans_backend_t sim_backend = {
+  "sim",
+  sim_init,
+  mtrans_host_alloc,
+  mtrans_host_free,
+  sim_transpose,
+  sim_finalize
+};
@@ -3,7 +3,12 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <limits.h>
 #include <unistd.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 #define CL_VERSION_2_0
 #include <CL/cl_ext_intelfpga.h> // to disable interleaving & transfer data to specific banks - CL_CHANNEL_1_INTELFPGA
@@ -12,45 +17,385 @@
 #include "transpose_fpga.h"
 #include "opencl_utils.h"
 #include "helper.h"
+#include "cpu_transpose.h"
+#include "mtrans_backend.h"
+#include "buf_pool.h"
+
+#define MAX_BANKS 4
+
+// Pipelines of a banked or replicated bitstream
+#define MAX_PIPELINES 8
+
+// Chunks of a plan per window of mapped files streamed by mTranspose_file()
+#define FILE_WINDOW 8
+
+// Milliseconds persistent kernels may take to store a posted descriptor, and
+// longest sleep in microseconds between the polls of its done word
+#define PERSIST_TIMEOUT_MS 10000
+#define PERSIST_MAX_WAIT_US 1000
+
+/*
+ * Program and command queues of a device of the platform. Every device loads
+ * the same bitstream.
+ *
+ * Banked bitstreams run a pipeline per DDR bank, named fetch<b>, transpose<b>
+ * and store<b>, each pipeline with its queues. Bank 0 uses queue1, 2 and 3.
+ * Replicated bitstreams run REPL such pipelines spread over the DDR banks
+ * reported by their banks kernel.
+ *
+ * Persistent bitstreams, reported by their persistent kernel, have an autorun
+ * transpose kernel, not created by the host. Their fetch and store kernels
+ * are launched once by a plan and serve the transpositions posted through a
+ * doorbell until the plan is destroyed.
+ */
+typedef struct fpga_device {
+  cl_device_id id;
+  cl_program program;
+  cl_command_queue queue1, queue2, queue3;
+  // Dedicated queues for PCIe transfers that overlap with kernel execution
+  cl_command_queue queue4, queue5;
+  int banks;  // pipelines, 0 if the bitstream is neither banked nor replicated
+  int mem_banks;  // DDR banks of the buffers of the pipelines
+  int replicated; // 1 if the pipelines are replicas spread over mem_banks
+  int logn;   // log of the length of the bitstream, the largest if sized at
+              // runtime, 0 if the bitstream does not report it
+  int runtime_size;  // 1 if any length up to 2^logn is transposed
+  int logpoints;     // log of the elements per cycle, 0 if not reported
+  int persistent;    // 1 if the kernels run until stopped, fed by a doorbell
+  fpga_plan_t *persist_plan;  // plan whose persistent kernels are running
+  cl_command_queue bank_queue[MAX_PIPELINES][3];
+  double rate;  // matrices per ms measured by mTranspose_multi(), 0 if none
+  // enqueues of concurrent submissions in the same order on every queue
+  pthread_mutex_t submit_lock;
+} fpga_device_t;
 
 #ifndef KERNEL_VARS
 #define KERNEL_VARS
 static cl_platform_id platform = NULL;
 static cl_device_id *devices;
-static cl_device_id device = NULL;
 static cl_context context = NULL;
-static cl_program program = NULL;
-static cl_command_queue queue1 = NULL, queue2 = NULL, queue3 = NULL;
+static fpga_device_t *fpga_dev = NULL;
+static int num_fpga_dev = 0;
 #endif
 
-static void queue_setup();
+/*
+ * Host memory allocated by fpgaf_complex_malloc() with svm. If every device
+ * supports fine grained SVM, the memory is shared with the kernels, which
+ * fetch and store it over PCIe without any copy. Otherwise it is pinned, a
+ * buffer allocated by the runtime mapped to the host, transferred by DMA
+ * without staging copies.
+ */
+typedef struct host_buf {
+  void *ptr;
+  size_t sz;
+  cl_mem pinned;  // NULL if shared virtual memory
+  struct host_buf *next;
+} host_buf_t;
+
+static host_buf_t *host_bufs = NULL;
+static pthread_mutex_t host_bufs_lock = PTHREAD_MUTEX_INITIALIZER;
+static int svm_shared = 0;
+
+/*
+ * Device buffers of plans, recycled by size and bank across plans instead of
+ * created and released by every mTranspose() call
+ */
+static buf_pool_t *dev_pool = NULL;
+static size_t dev_pool_cap = 0;
+
+static const cl_mem_flags bank_channel[MAX_BANKS] = {
+  CL_CHANNEL_1_INTELFPGA, CL_CHANNEL_2_INTELFPGA,
+  CL_CHANNEL_3_INTELFPGA, CL_CHANNEL_4_INTELFPGA
+};
+
+/*
+ * Persistent state required to transpose a batch of N x N matrices. Kernels
+ * and device buffers are created once and reused by every execution of the
+ * plan. The command queues are shared by all plans and live as long as the
+ * FPGA is initialized.
+ *
+ * Buffers at index 0 are used by every execution, index 1 is allocated only
+ * when the plan streams chunks alternating between both pairs of buffers.
+ * The output buffers of an in place plan are its input buffers, store
+ * writing every matrix over the one it was fetched from.
+ */
+struct fpga_plan {
+  fpga_device_t *dev;
+  int N;
+  int batch;
+  int isND;
+  size_t elem_sz;  // bytes of an element of the bitstream's TYPE
+  int points;      // elements per cycle, a memory word of the bitstream
+  size_t buf_sz;
+  int inplace;     // output buffers alias the input ones, one per batch
+  cl_kernel fetch_kernel, transpose_kernel, store_kernel;
+  cl_mem d_inData[2], d_outData[2];
+
+  // pipelines of a banked bitstream instead of the kernels and buffers above
+  int banks;
+  int bank_batch;  // matrices per bank
+  cl_kernel bank_kernels[MAX_PIPELINES][3];
+  cl_mem d_bankIn[MAX_PIPELINES], d_bankOut[MAX_PIPELINES];
+
+  // kernels of a persistent bitstream running since the plan was created,
+  // polling the doorbell for the sequence number of the next descriptor
+  int persistent;
+  int hung;    // 1 once a descriptor was not stored in time
+  cl_mem d_doorbell, d_done;
+  cl_int seq;  // of the last descriptor posted
+
+  // last fetch and read of each pair of buffers by a submitted request
+  int async_next;
+  cl_event async_fetch[2], async_read[2];
+
+  // device side profile of the last execution
+  fpga_profile_t profile;
+};
+
+/*
+ * Transposition submitted by mTranspose_submit(), complete once the read of
+ * its output is. Requests alternate between the two pairs of buffers of the
+ * plan, waiting for the previous request on the same pair as a stream of
+ * chunks does.
+ */
+struct fpga_request {
+  cl_event write_ev, fetch_ev, transpose_ev, store_ev, read_ev;
+  fpga_callback_t callback;
+  void *user_data;
+  pthread_mutex_t lock;
+  pthread_cond_t done_cv;
+  int done;
+  int detached;  // released before completion, freed by it
+  fpga_t timing;
+  fpga_profile_t profile;
+};
+
+static void queue_setup(fpga_device_t *dev);
 void queue_cleanup();
+static void launch_kernels(fpga_plan_t *plan, int batch, cl_mem d_in, cl_mem d_out, cl_event *fetch_wait, cl_event *store_wait, cl_event *fetch_done, cl_event *transpose_done, cl_event *store_done);
+static void enqueue_kernels(fpga_plan_t *plan, int batch, cl_event *fetch_wait, cl_event *store_wait, cl_event *fetch_done, cl_event *transpose_done, cl_event *store_done);
+static void profile_events(fpga_profile_t *prof, cl_event write_ev, cl_event fetch_ev, cl_event transpose_ev, cl_event store_ev, cl_event read_ev);
+static int alloc_second_pair(fpga_plan_t *plan);
+static fpga_plan_t* plan_create(fpga_device_t *dev, int N, int batch, int isND, size_t elem_sz, int inplace);
+static fpga_t plan_stream(fpga_plan_t *plan, void *inp, void *out, int batch);
+static fpga_t plan_execute(fpga_plan_t *plan, void *inp, void *out, int batch);
+static int count_banks(cl_program program);
+static int query_word(fpga_device_t *dev, const char *name);
+static int query_banks(fpga_device_t *dev);
+static int query_size(fpga_device_t *dev, int *runtime_size, int *logpoints);
+static int bank_create(fpga_plan_t *plan);
+static fpga_t bank_execute(fpga_plan_t *plan, void *inp, void *out, int batch);
+static int persist_create(fpga_plan_t *plan);
+static int persist_post(fpga_plan_t *plan, int offset, int batch);
+static fpga_t persist_execute(fpga_plan_t *plan, void *inp, void *out, int batch);
+static void persist_stop(fpga_plan_t *plan);
+static fpga_t svm_execute(fpga_plan_t *plan, void *inp, void *out, int batch);
+static void* host_buf_alloc(size_t sz);
+static host_buf_t* host_buf_find(const void *ptr, size_t sz);
+static void host_buf_release(host_buf_t *buf);
+static void async_drain(fpga_plan_t *plan);
 
 /** 
  * @brief Allocate memory of single precision complex floating points
  * @param sz  : size_t : size to allocate
- * @param svm : 1 if svm
+ * @param svm : 1 if svm, shared with the kernels or pinned, requires
+ *              fpga_initialize() and release by fpga_complex_free()
  * @return void ptr or NULL
  */
 void* fpgaf_complex_malloc(size_t sz, int svm){
-  if(svm == 1){
-    fprintf(stderr, "Working in progress\n");
+  if(sz == 0){
+    return NULL;
+  }
+  else if(svm == 1){
+    return host_buf_alloc(sz);
+  }
+  else{
+    return mtrans_host_alloc(sz);
+  }
+}
+
+/** 
+ * @brief Allocate memory of double precision complex floating points
+ * @param sz  : size_t : size to allocate
+ * @param svm : 1 if svm
+ * @return void ptr or NULL
+ */
+void* fpgad_complex_malloc(size_t sz, int svm){
+  return fpgaf_complex_malloc(sz, svm);
+}
+
+/**
+ * \brief  release memory of fpgaf_complex_malloc() or fpgad_complex_malloc(),
+ *         before fpga_final() if allocated with svm
+ */
+void fpga_complex_free(void *ptr){
+  if(ptr == NULL)
+    return;
+
+  pthread_mutex_lock(&host_bufs_lock);
+  host_buf_t **prev = &host_bufs;
+  while(*prev != NULL && (*prev)->ptr != ptr)
+    prev = &(*prev)->next;
+  host_buf_t *buf = *prev;
+  if(buf != NULL)
+    *prev = buf->next;
+  pthread_mutex_unlock(&host_bufs_lock);
+
+  if(buf != NULL)
+    host_buf_release(buf);
+  else
+    mtrans_host_free(ptr);
+}
+
+/**
+ * \brief  1 if svm memory is shared with the kernels, 0 if pinned
+ */
+int fpga_svm_shared(){
+  return svm_shared;
+}
+
+/**
+ * \brief  cap the bytes of device buffers in use and kept for reuse by
+ *         plans, 0 for no limit. Plans beyond it fail to be created.
+ */
+void fpga_pool_limit(size_t bytes){
+  dev_pool_cap = bytes;
+  buf_pool_limit(dev_pool, bytes);
+}
+
+/**
+ * \brief  hits, misses and bytes of the pool of device buffers
+ */
+void fpga_pool_stats(fpga_pool_stats_t *stats){
+  if(stats == NULL)
+    return;
+
+  memset(stats, 0, sizeof(fpga_pool_stats_t));
+  stats->cap_bytes = dev_pool_cap;
+  buf_pool_stats(dev_pool, stats);
+}
+
+/**
+ * \brief  allocate host memory shared with the kernels if every device
+ *         supports fine grained SVM, else pinned by the runtime
+ */
+static void* host_buf_alloc(size_t sz){
+  cl_int status = 0;
+
+  if(context == NULL || num_fpga_dev == 0){
+    fprintf(stderr, "SVM memory requires an initialized FPGA\n");
+    return NULL;
+  }
+
+  host_buf_t *buf = (host_buf_t *)calloc(1, sizeof(host_buf_t));
+  if(buf == NULL){
     return NULL;
-    // return aocl_mmd_shared_mem_alloc(svm_handle, sizeof(double2) * sz, inData, device_ptr);
   }
-  else if(sz == 0){
+  buf->sz = sz;
+
+  if(svm_shared){
+    buf->ptr = clSVMAlloc(context, CL_MEM_READ_WRITE | CL_MEM_SVM_FINE_GRAIN_BUFFER, sz, 64);
+  }
+  else{
+    buf->pinned = clCreateBuffer(context, CL_MEM_READ_WRITE | CL_MEM_ALLOC_HOST_PTR, sz, NULL, &status);
+    if(status == CL_SUCCESS){
+      buf->ptr = clEnqueueMapBuffer(fpga_dev[0].queue1, buf->pinned, CL_TRUE, CL_MAP_READ | CL_MAP_WRITE, 0, sz, 0, NULL, NULL, &status);
+    }
+    if(status != CL_SUCCESS){
+      if(buf->pinned)
+        clReleaseMemObject(buf->pinned);
+      buf->ptr = NULL;
+    }
+  }
+
+  if(buf->ptr == NULL){
+    fprintf(stderr, "Failed to allocate %zu bytes of %s memory\n", sz, svm_shared ? "SVM" : "pinned");
+    free(buf);
     return NULL;
   }
+
+  pthread_mutex_lock(&host_bufs_lock);
+  buf->next = host_bufs;
+  host_bufs = buf;
+  pthread_mutex_unlock(&host_bufs_lock);
+
+  return buf->ptr;
+}
+
+/**
+ * \brief  svm allocation holding sz bytes from ptr, NULL if none
+ */
+static host_buf_t* host_buf_find(const void *ptr, size_t sz){
+  const char *p = (const char *)ptr;
+
+  pthread_mutex_lock(&host_bufs_lock);
+  host_buf_t *buf = host_bufs;
+  while(buf != NULL){
+    const char *base = (const char *)buf->ptr;
+    if(p >= base && sz <= buf->sz && (size_t)(p - base) <= buf->sz - sz)
+      break;
+    buf = buf->next;
+  }
+  pthread_mutex_unlock(&host_bufs_lock);
+
+  return buf;
+}
+
+/**
+ * \brief  unmap and release pinned memory or free shared virtual memory
+ */
+static void host_buf_release(host_buf_t *buf){
+  if(buf->pinned){
+    clEnqueueUnmapMemObject(fpga_dev[0].queue1, buf->pinned, buf->ptr, 0, NULL, NULL);
+    clFinish(fpga_dev[0].queue1);
+    clReleaseMemObject(buf->pinned);
+  }
   else{
-    return ((float2 *)alignedMalloc(sz));
+    clSVMFree(context, buf->ptr);
   }
+  free(buf);
+}
+
+/**
+ * \brief  create a device buffer in the bank of its key
+ */
+static void* dev_buf_create(size_t sz, uint64_t channel){
+  cl_int status = 0;
+
+  cl_mem mem = clCreateBuffer(context, CL_MEM_READ_WRITE | (cl_mem_flags)channel, sz, NULL, &status);
+  checkError(status, "Failed to allocate device buffer\n");
+  return mem;
+}
+
+static void dev_buf_destroy(void *buf, size_t sz, uint64_t channel){
+  clReleaseMemObject((cl_mem)buf);
+}
+
+/**
+ * \brief  device buffer of a plan from the pool
+ * \retval buffer or NULL beyond the cap of the pool
+ */
+static cl_mem dev_buf_acquire(size_t sz, cl_mem_flags channel){
+  cl_mem mem = (cl_mem)buf_pool_acquire(dev_pool, sz, channel, NULL);
+  if(mem == NULL){
+    fprintf(stderr, "Failed to allocate device buffer of %zu bytes within the pool\n", sz);
+  }
+  return mem;
+}
+
+/**
+ * \brief  return a device buffer to the pool, released if not from it
+ */
+static void dev_buf_release(cl_mem mem){
+  if(mem != NULL && buf_pool_release(dev_pool, mem) != 0)
+    clReleaseMemObject(mem);
 }
 
 /** 
  * @brief Initialize FPGA
  * @param platform name: string - name of the OpenCL platform
  * @param path         : string - path to binary
- * @param use_svm      : 1 if true 0 otherwise
+ * @param use_svm      : 1 to report whether svm memory is shared or pinned
  * @param use_emulator : 1 if true 0 otherwise
  * @return 0 if successful 
  */
@@ -81,30 +426,69 @@ int fpga_initialize(const char *platform_name, const char *path, int use_svm, in
     return 1;
   }
 
-  // use the first device.
-  device = devices[0];
-
-  // Create the context.
-  context = clCreateContext(NULL, 1, &device, NULL, NULL, &status);
+  // one context for all devices, a program and queues per device
+  context = clCreateContext(NULL, num_devices, devices, NULL, NULL, &status);
   checkError(status, "Failed to create context");
 
-#ifdef VERBOSE
-  printf("\tGetting program binary from path %s ...\n", path);
-#endif
-  // Create the program.
-  program = getProgramWithBinary(context, &device, 1, path);
-  if(program == NULL) {
-    fprintf(stderr, "Failed to create program\n");
+  dev_pool = buf_pool_create(dev_pool_cap, dev_buf_create, dev_buf_destroy);
+
+  fpga_dev = (fpga_device_t *)calloc(num_devices, sizeof(fpga_device_t));
+  if(fpga_dev == NULL){
     fpga_final();
     return 1;
   }
+  num_fpga_dev = num_devices;
+
+  // svm memory is shared with the kernels only if every device accesses it
+  svm_shared = 1;
+  for(int d = 0; d < num_fpga_dev; d++){
+    cl_device_svm_capabilities caps = 0;
+    status = clGetDeviceInfo(devices[d], CL_DEVICE_SVM_CAPABILITIES, sizeof(caps), &caps, NULL);
+    if(status != CL_SUCCESS || !(caps & CL_DEVICE_SVM_FINE_GRAIN_BUFFER))
+      svm_shared = 0;
+  }
+  if(use_svm){
+    printf("SVM memory %s\n", svm_shared ? "shared with the kernels" : "pinned for DMA transfers");
+  }
+
+  for(int d = 0; d < num_fpga_dev; d++){
+    fpga_device_t *dev = &fpga_dev[d];
+    dev->id = devices[d];
+    pthread_mutex_init(&dev->submit_lock, NULL);
+
+#ifdef VERBOSE
+    printf("\tGetting program binary from path %s for device %d ...\n", path, d);
+#endif
+    // Create the program.
+    dev->program = getProgramWithBinary(context, &dev->id, 1, path);
+    if(dev->program == NULL) {
+      fprintf(stderr, "Failed to create program\n");
+      fpga_final();
+      return 1;
+    }
 
 #ifdef VERBOSE
-  printf("\tBuilding program ...\n");
+    printf("\tBuilding program ...\n");
 #endif
-  // Build the program that was just created.
-  status = clBuildProgram(program, 0, NULL, "", NULL, NULL);
-  checkError(status, "Failed to build program");
+    // Build the program that was just created.
+    status = clBuildProgram(dev->program, 0, NULL, "", NULL, NULL);
+    checkError(status, "Failed to build program");
+
+    dev->banks = count_banks(dev->program);
+
+    // Command queues are reused by every transposition until finalized
+    queue_setup(dev);
+
+    // marked by its persistent kernel, its transpose kernel is autorun
+    dev->persistent = (query_word(dev, "persistent") == 1);
+
+    dev->logn = query_size(dev, &dev->runtime_size, &dev->logpoints);
+
+    // a bank per pipeline unless replicated over fewer
+    int mem_banks = query_banks(dev);
+    dev->replicated = (mem_banks > 0);
+    dev->mem_banks = dev->replicated ? mem_banks : ((dev->banks < MAX_BANKS) ? dev->banks : MAX_BANKS);
+  }
 
   return 0;
 }
@@ -117,161 +501,2356 @@ void fpga_final(){
 #ifdef VERBOSE
   printf("\tCleaning up FPGA resources ...\n");
 #endif
-  if(program) 
-    clReleaseProgram(program);
+  // svm memory not yet released, unmapped while the queues exist
+  pthread_mutex_lock(&host_bufs_lock);
+  host_buf_t *buf = host_bufs;
+  host_bufs = NULL;
+  pthread_mutex_unlock(&host_bufs_lock);
+  while(buf != NULL){
+    host_buf_t *next = buf->next;
+    host_buf_release(buf);
+    buf = next;
+  }
+
+  queue_cleanup();
+
+  buf_pool_destroy(dev_pool);
+  dev_pool = NULL;
+
+  for(int d = 0; d < num_fpga_dev; d++){
+    if(fpga_dev[d].program) 
+      clReleaseProgram(fpga_dev[d].program);
+    pthread_mutex_destroy(&fpga_dev[d].submit_lock);
+  }
   if(context)
     clReleaseContext(context);
+  free(fpga_dev);
   free(devices);
+
+  fpga_dev = NULL;
+  num_fpga_dev = 0;
+  context = NULL;
+  devices = NULL;
+  svm_shared = 0;
 }
 
 /**
- * \brief  compute an complex single precision matrix transposition on the FPGA
- * \param  N   : length of the matrix
- * \param  inp : pointer to input matrix
- * \param  out : pointer to output matrix
- * \param  batch : number of transposes to perform in a batched mode
- * \param  use_svm : 1 if pcie transfers are SVM based
- * \param  isND : 1 if kernel is ND Range
- * \retval fpga_t : time taken in milliseconds for data transfers and execution
+ * \brief  number of pipelines of a banked bitstream placing their buffers in
+ *         a DDR bank each, or of a replicated one spreading them over the banks
+ * \retval pipelines, 0 if the bitstream has a single pipeline
  */
-fpga_t mTranspose(int N, float2 *inp, float2 *out, int batch, int use_svm, int isND){
-  fpga_t mTranspose_time = {0.0, 0.0, 0.0, 0};
-  cl_kernel fetch_kernel = NULL, transpose_kernel = NULL, store_kernel = NULL;
-  cl_int status = 0;
+int fpga_banks(){
+  return (num_fpga_dev > 0) ? fpga_dev[0].banks : 0;
+}
 
-  // if N is not a power of 2
-  if(inp == NULL || out == NULL || ((N & (N-1)) !=0)){
-    return mTranspose_time;
-  }
+/**
+ * \brief  DDR banks the replicated pipelines of fpga_banks() are spread over
+ * \retval banks, 0 if the bitstream is not replicated
+ */
+int fpga_replicated_banks(){
+  return (num_fpga_dev > 0 && fpga_dev[0].replicated) ? fpga_dev[0].mem_banks : 0;
+}
 
-  queue_setup();
+/**
+ * \brief  length of the matrices transposed by the bitstream, the largest if
+ *         sized at runtime, see fpga_runtime_size()
+ * \retval length, 0 if the bitstream does not report it
+ */
+int fpga_size(){
+  return (num_fpga_dev > 0 && fpga_dev[0].logn > 0) ? (1 << fpga_dev[0].logn) : 0;
+}
 
-  //unsigned num_pts = batch * N * N;
-  size_t buf_sz = sizeof(float2) * batch * N * N;
+/**
+ * \brief  1 if the bitstream transposes any length from a memory word up to
+ *         fpga_size() given at runtime, 0 if a single length
+ */
+int fpga_runtime_size(){
+  return (num_fpga_dev > 0) ? fpga_dev[0].runtime_size : 0;
+}
 
-  // Create device buffers 
-  cl_mem d_inData, d_outData;
-  d_inData = clCreateBuffer(context, CL_MEM_READ_WRITE | CL_CHANNEL_1_INTELFPGA, buf_sz, NULL, &status);
-  checkError(status, "Failed to allocate input device buffer\n");
+/**
+ * \brief  elements of a memory word moved per cycle by the bitstream
+ * \retval points, 0 if the bitstream does not report it
+ */
+int fpga_points(){
+  return (num_fpga_dev > 0 && fpga_dev[0].logpoints > 0) ? (1 << fpga_dev[0].logpoints) : 0;
+}
 
-  d_outData = clCreateBuffer(context, CL_MEM_READ_WRITE | CL_CHANNEL_2_INTELFPGA, buf_sz, NULL, &status);
-  checkError(status, "Failed to allocate output device buffer\n");
+/**
+ * \brief  largest batch of N x N single precision complex matrices of a plan
+ *         within the global memory of the device, and every buffer within
+ *         the largest allocation. In place plans have half the buffers.
+ * \param  inplace : 1 for plans created by mTranspose_plan_inplace()
+ * \retval batch, 0 if not initialized
+ */
+int fpga_max_batch(int N, int inplace){
+  cl_ulong global_sz = 0, alloc_sz = 0;
 
- // Copy data from host to device
-  mTranspose_time.pcie_write_t = getTimeinMilliSec();
+  if(num_fpga_dev == 0 || N <= 0){
+    return 0;
+  }
 
-  status = clEnqueueWriteBuffer(queue1, d_inData, CL_TRUE, 0, buf_sz, inp, 0, NULL, NULL);
+  fpga_device_t *dev = &fpga_dev[0];
+  cl_int status = clGetDeviceInfo(dev->id, CL_DEVICE_GLOBAL_MEM_SIZE, sizeof(cl_ulong), &global_sz, NULL);
+  checkError(status, "Failed to query global memory size");
+  status = clGetDeviceInfo(dev->id, CL_DEVICE_MAX_MEM_ALLOC_SIZE, sizeof(cl_ulong), &alloc_sz, NULL);
+  checkError(status, "Failed to query largest allocation");
 
-  mTranspose_time.pcie_write_t = getTimeinMilliSec() - mTranspose_time.pcie_write_t;
-  checkError(status, "Failed to copy data to device");
+  // a buffer per pipeline, or an input and an output one
+  const cl_ulong mat_sz = sizeof(float2) * (cl_ulong)N * N;
+  const cl_ulong buffers = inplace ? 1 : 2;
+  const cl_ulong pipelines = (dev->banks > 0) ? dev->banks : 1;
 
-  // create kernel
-  fetch_kernel = clCreateKernel(program, "fetch", &status);
-  checkError(status, "Failed to create fetch kernel");
-  transpose_kernel = clCreateKernel(program, "transpose", &status);
-  checkError(status, "Failed to create transpose kernel");
-  store_kernel = clCreateKernel(program, "store", &status);
-  checkError(status, "Failed to create store kernel");
+  cl_ulong batch = global_sz / (buffers * mat_sz);
+  if((alloc_sz / mat_sz) * pipelines < batch)
+    batch = (alloc_sz / mat_sz) * pipelines;
+  return (batch > INT_MAX) ? INT_MAX : (int)batch;
+}
 
-  // kernel args
-  status = clSetKernelArg(fetch_kernel, 0, sizeof(cl_mem), (void *)&d_inData);
-  checkError(status, "Failed to set fetch kernel arg 0");
-  status = clSetKernelArg(fetch_kernel, 1, sizeof(cl_int), (void*)&batch);
-  checkError(status, "Failed to set fetch kernel arg 1");
+/**
+ * \brief  1 if the kernels of the bitstream are launched once per plan and
+ *         fed the transpositions through a doorbell, 0 if launched by each
+ */
+int fpga_persistent(){
+  return (num_fpga_dev > 0) ? fpga_dev[0].persistent : 0;
+}
 
-  status = clSetKernelArg(transpose_kernel, 0, sizeof(cl_int), (void*)&batch);
-  checkError(status, "Failed to set fetch kernel arg");
+/**
+ * \brief  number of FPGAs of the platform
+ */
+int fpga_devices(){
+  return num_fpga_dev;
+}
 
-  status = clSetKernelArg(store_kernel, 0, sizeof(cl_mem), (void *)&d_outData);
-  checkError(status, "Failed to set transpose kernel arg 0");
-  status = clSetKernelArg(store_kernel, 1, sizeof(cl_int), (void*)&batch);
-  checkError(status, "Failed to set fetch kernel arg 1");
+/**
+ * \brief  count the pipelines of the program, fetch0 to fetch3. OpenCL does
+ *         not expose the DDR channels of a board, the bitstream is built
+ *         with a pipeline per channel instead.
+ */
+static int count_banks(cl_program program){
+  char name[16];
+  int banks = 0;
 
-  double start = getTimeinMilliSec();
-  if(isND){
-    size_t lws_transfer[] = {N};
-    size_t gws_transfer[] = {batch * N * N / 8}; 
+  for(; banks < MAX_PIPELINES; banks++){
+    cl_int status = 0;
+    snprintf(name, sizeof(name), "fetch%d", banks);
+    cl_kernel kernel = clCreateKernel(program, name, &status);
+    if(status != CL_SUCCESS)
+      break;
+    clReleaseKernel(kernel);
+  }
+  return banks;
+}
 
-    status = clEnqueueNDRangeKernel(queue1, fetch_kernel, 1, 0, gws_transfer, lws_transfer, 0, NULL, NULL);
-    checkError(status, "Failed to launch kernel");
+/**
+ * \brief  word written by the kernel of the name, that the host launches on
+ *         initialization to read a property of the program
+ * \retval word, 0 if the program has no such kernel
+ */
+static int query_word(fpga_device_t *dev, const char *name){
+  cl_int status = 0;
+  cl_int word = 0;
 
-    size_t lws_transpose_kernel[] = {N * N / 8};
-    size_t gws_transpose_kernel[] = {batch * N * N / 8}; 
-    status = clEnqueueNDRangeKernel(queue2, transpose_kernel, 1, 0, gws_transpose_kernel, lws_transpose_kernel, 0, NULL, NULL);
-    checkError(status, "Failed to launch kernel");
+  cl_kernel kernel = clCreateKernel(dev->program, name, &status);
+  if(status != CL_SUCCESS)
+    return 0;
 
-    status = clEnqueueNDRangeKernel(queue3, store_kernel, 1, 0, gws_transfer, lws_transfer, 0, NULL, NULL);
-    checkError(status, "Failed to launch kernel");
-  }
-  else{
-    status = clEnqueueTask(queue1, fetch_kernel, 0, NULL, NULL);
-    checkError(status, "Failed to launch fetch kernel");
+  cl_mem d_word = clCreateBuffer(context, CL_MEM_WRITE_ONLY, sizeof(cl_int), NULL, &status);
+  checkError(status, "Failed to allocate word buffer");
+  status = clSetKernelArg(kernel, 0, sizeof(cl_mem), (void *)&d_word);
+  checkError(status, "Failed to set word kernel arg 0");
+  status = clEnqueueTask(dev->queue1, kernel, 0, NULL, NULL);
+  checkError(status, "Failed to launch word kernel");
+  status = clEnqueueReadBuffer(dev->queue1, d_word, CL_TRUE, 0, sizeof(cl_int), &word, 0, NULL, NULL);
+  checkError(status, "Failed to read word");
 
-    status = clEnqueueTask(queue2, transpose_kernel, 0, NULL, NULL);
-    checkError(status, "Failed to launch transpose kernel");
+  clReleaseMemObject(d_word);
+  clReleaseKernel(kernel);
+  return word;
+}
 
-    status = clEnqueueTask(queue3, store_kernel, 0, NULL, NULL);
-    checkError(status, "Failed to launch store kernel");
-  }
+/**
+ * \brief  DDR banks a replicated program spreads its pipelines over, written
+ *         by its banks kernel
+ * \retval banks, 0 if the program is not replicated
+ */
+static int query_banks(fpga_device_t *dev){
+  int banks = query_word(dev, "banks");
+  return (banks > 0 && banks <= MAX_BANKS) ? banks : 0;
+}
 
-  // Wait for all command queues to complete pending events
-  status = clFinish(queue1);
-  checkError(status, "failed to finish");
-  status = clFinish(queue2);
-  checkError(status, "failed to finish");
-  status = clFinish(queue3);
-  checkError(status, "failed to finish");
+/**
+ * \brief  log of the length and of the points per cycle of the program,
+ *         written by its size kernel, or its max_size kernel for a program
+ *         sized at runtime
+ * \param  runtime_size: set to 1 if sized at runtime
+ * \param  logpoints: set to the log of the points per cycle
+ * \retval log of the length, 0 if the program has neither kernel
+ */
+static int query_size(fpga_device_t *dev, int *runtime_size, int *logpoints){
+  static const char *const name[2] = {"size", "max_size"};
+  cl_int status = 0;
+  cl_int size[2] = {0, 0};  // logn, logpoints
 
-  double stop = getTimeinMilliSec();
-  mTranspose_time.exec_t = stop - start;
+  *runtime_size = 0;
+  *logpoints = 0;
+  for(int r = 0; r < 2; r++){
+    cl_kernel kernel = clCreateKernel(dev->program, name[r], &status);
+    if(status != CL_SUCCESS)
+      continue;
 
-  mTranspose_time.pcie_read_t = getTimeinMilliSec();
+    cl_mem d_size = clCreateBuffer(context, CL_MEM_WRITE_ONLY, sizeof(size), NULL, &status);
+    checkError(status, "Failed to allocate size buffer");
+    status = clSetKernelArg(kernel, 0, sizeof(cl_mem), (void *)&d_size);
+    checkError(status, "Failed to set size kernel arg 0");
+    status = clEnqueueTask(dev->queue1, kernel, 0, NULL, NULL);
+    checkError(status, "Failed to launch size kernel");
+    status = clEnqueueReadBuffer(dev->queue1, d_size, CL_TRUE, 0, sizeof(size), size, 0, NULL, NULL);
+    checkError(status, "Failed to read size");
 
-  status = clEnqueueReadBuffer(queue1, d_outData, CL_TRUE, 0, buf_sz, out, 0, NULL, NULL);
+    clReleaseMemObject(d_size);
+    clReleaseKernel(kernel);
+    *runtime_size = r;
+    *logpoints = size[1];
+    break;
+  }
+  return size[0];
+}
 
-  mTranspose_time.pcie_read_t = getTimeinMilliSec() - mTranspose_time.pcie_read_t;
-  checkError(status, "Failed to read data from device");
+/**
+ * \brief  create a plan to transpose batches of N x N single precision complex
+ *         matrices. The kernels and the device buffers are created once and
+ *         reused by every call to mTranspose_execute()
+ * \param  N     : length of the matrix
+ * \param  batch : maximum number of matrices transposed per execution
+ * \param  isND  : 1 if kernel is ND Range
+ * \retval plan or NULL if the parameters are invalid
+ */
+fpga_plan_t* mTranspose_plan(int N, int batch, int isND){
+  return plan_create(fpga_dev, N, batch, isND, sizeof(float2), 0);
+}
 
-  queue_cleanup();
+/**
+ * \brief  create a plan as mTranspose_plan() for double precision complex
+ *         matrices, requires a bitstream built with TYPE double2
+ */
+fpga_plan_t* mTranspose_plan_d(int N, int batch, int isND){
+  return plan_create(fpga_dev, N, batch, isND, sizeof(double2), 0);
+}
 
-  if (d_inData)
-  	clReleaseMemObject(d_inData);
-  if (d_outData)
-  	clReleaseMemObject(d_outData);
+/**
+ * \brief  create a plan as mTranspose_plan() for real single precision
+ *         matrices, requires a bitstream built with TYPE float
+ */
+fpga_plan_t* mTranspose_plan_r(int N, int batch, int isND){
+  return plan_create(fpga_dev, N, batch, isND, sizeof(float), 0);
+}
 
-  if(fetch_kernel) 
-    clReleaseKernel(fetch_kernel);  
-  if(transpose_kernel) 
-    clReleaseKernel(transpose_kernel);  
-  if(store_kernel) 
-    clReleaseKernel(store_kernel);  
+/**
+ * \brief  create a plan as mTranspose_plan() for half precision matrices,
+ *         requires a bitstream built with TYPE half
+ */
+fpga_plan_t* mTranspose_plan_h(int N, int batch, int isND){
+  return plan_create(fpga_dev, N, batch, isND, sizeof(half_t), 0);
+}
 
-  mTranspose_time.valid = 1;
-  return mTranspose_time;
+/**
+ * \brief  create a plan as mTranspose_plan() for bfloat16 matrices, requires
+ *         a bitstream built with TYPE bf16
+ */
+fpga_plan_t* mTranspose_plan_bf(int N, int batch, int isND){
+  return plan_create(fpga_dev, N, batch, isND, sizeof(bf16_t), 0);
 }
 
 /**
- * \brief Create a command queue for each kernel
+ * \brief  create a plan as mTranspose_plan() transposing in place on the
+ *         device, a single buffer per batch instead of an input and an
+ *         output one, doubling the largest batch of the device memory. The
+ *         kernels fetch every matrix before storing its transpose, so store
+ *         only writes matrices fetch is done with.
  */
-void queue_setup(){
-  cl_int status = 0;
-  // Create one command queue for each kernel.
-  queue1 = clCreateCommandQueue(context, device, CL_QUEUE_PROFILING_ENABLE, &status);
-  checkError(status, "Failed to create command queue1");
-  queue2 = clCreateCommandQueue(context, device, CL_QUEUE_PROFILING_ENABLE, &status);
-  checkError(status, "Failed to create command queue2");
-  queue3 = clCreateCommandQueue(context, device, CL_QUEUE_PROFILING_ENABLE, &status);
-  checkError(status, "Failed to create command queue3");
+fpga_plan_t* mTranspose_plan_inplace(int N, int batch, int isND){
+  return plan_create(fpga_dev, N, batch, isND, sizeof(float2), 1);
 }
 
 /**
- * \brief Release all command queues
+ * \brief  create a plan for elements of elem_sz bytes
+ * \param  inplace : 1 to store into the buffers fetched from
  */
-void queue_cleanup() {
-  if(queue1) 
-    clReleaseCommandQueue(queue1);
-  if(queue2) 
-    clReleaseCommandQueue(queue2);
-  if(queue3) 
-    clReleaseCommandQueue(queue3);
-}
\ No newline at end of file
+static fpga_plan_t* plan_create(fpga_device_t *dev, int N, int batch, int isND, size_t elem_sz, int inplace){
+  cl_int status = 0;
+
+  if(dev == NULL){
+    return NULL;
+  }
+
+  // points per cycle the bitstream was built with, otherwise its default of
+  // a 512 bit word of narrow elements or 8 complex ones
+  int points = (elem_sz >= sizeof(float2)) ? 8 : (int)(64 / elem_sz);
+  if(dev->logpoints > 0)
+    points = 1 << dev->logpoints;
+
+  // if N is not a power of 2 or shorter than a word
+  if(N < points || batch <= 0 || ((N & (N-1)) !=0)){
+    return NULL;
+  }
+
+  // or not transposed by the bitstream, any N up to its largest if sized at
+  // runtime, otherwise its only N
+  cl_int logn = 0;
+  while((1 << logn) < N)
+    logn++;
+  if(dev->logn > 0 && (dev->runtime_size ? (logn > dev->logn) : (logn != dev->logn))){
+    return NULL;
+  }
+
+  fpga_plan_t *plan = (fpga_plan_t *)calloc(1, sizeof(fpga_plan_t));
+  if(plan == NULL){
+    return NULL;
+  }
+  plan->dev = dev;
+  plan->N = N;
+  plan->batch = batch;
+  plan->isND = isND;
+  plan->elem_sz = elem_sz;
+  plan->points = points;
+  plan->buf_sz = elem_sz * batch * N * N;
+  plan->inplace = inplace;
+
+  if(dev->banks > 0){
+    if(bank_create(plan)){
+      mTranspose_destroy(plan);
+      return NULL;
+    }
+    return plan;
+  }
+
+  // a single plan feeds the kernels of a persistent bitstream at a time
+  if(dev->persistent && dev->persist_plan != NULL){
+    fprintf(stderr, "Persistent kernels are in use by another plan\n");
+    free(plan);
+    return NULL;
+  }
+
+  // Device buffers recycled from previous plans
+  plan->d_inData[0] = dev_buf_acquire(plan->buf_sz, CL_CHANNEL_1_INTELFPGA);
+  plan->d_outData[0] = inplace ? plan->d_inData[0] : dev_buf_acquire(plan->buf_sz, CL_CHANNEL_2_INTELFPGA);
+  if(plan->d_inData[0] == NULL || plan->d_outData[0] == NULL){
+    mTranspose_destroy(plan);
+    return NULL;
+  }
+
+  if(dev->persistent){
+    if(persist_create(plan)){
+      mTranspose_destroy(plan);
+      return NULL;
+    }
+    return plan;
+  }
+
+  // create kernel
+  plan->fetch_kernel = clCreateKernel(dev->program, "fetch", &status);
+  checkError(status, "Failed to create fetch kernel");
+  plan->transpose_kernel = clCreateKernel(dev->program, "transpose", &status);
+  checkError(status, "Failed to create transpose kernel");
+  plan->store_kernel = clCreateKernel(dev->program, "store", &status);
+  checkError(status, "Failed to create store kernel");
+
+  // length of the plan passed once, the kernels keep it for every launch
+  if(dev->runtime_size){
+    status = clSetKernelArg(plan->fetch_kernel, 2, sizeof(cl_int), (void*)&logn);
+    checkError(status, "Failed to set fetch kernel arg 2");
+    status = clSetKernelArg(plan->transpose_kernel, 1, sizeof(cl_int), (void*)&logn);
+    checkError(status, "Failed to set transpose kernel arg 1");
+    status = clSetKernelArg(plan->store_kernel, 2, sizeof(cl_int), (void*)&logn);
+    checkError(status, "Failed to set store kernel arg 2");
+  }
+
+  return plan;
+}
+
+/**
+ * \brief  transpose a large batch of matrices by streaming chunks of the
+ *         plan's batch through two pairs of device buffers. While chunk k is
+ *         transposed, chunk k+1 is written to the device and chunk k-1 is
+ *         read back, overlapping PCIe transfers with kernel execution.
+ * \param  plan  : plan created using mTranspose_plan(), batch is the chunk size
+ * \param  inp   : pointer to input matrices
+ * \param  out   : pointer to output matrices
+ * \param  batch : total number of matrices to transpose
+ * \retval fpga_t : exec_t is the end-to-end time in milliseconds including 
+ *                  all PCIe transfers
+ */
+fpga_t mTranspose_stream(fpga_plan_t *plan, float2 *inp, float2 *out, int batch){
+  fpga_t mTranspose_time = {0.0, 0.0, 0.0, 0};
+
+  if(plan == NULL || plan->elem_sz != sizeof(float2)){
+    return mTranspose_time;
+  }
+  return plan_stream(plan, inp, out, batch);
+}
+
+/**
+ * \brief  stream as mTranspose_stream() double precision complex matrices
+ *         using a plan created by mTranspose_plan_d()
+ */
+fpga_t mTranspose_stream_d(fpga_plan_t *plan, double2 *inp, double2 *out, int batch){
+  fpga_t mTranspose_time = {0.0, 0.0, 0.0, 0};
+
+  if(plan == NULL || plan->elem_sz != sizeof(double2)){
+    return mTranspose_time;
+  }
+  return plan_stream(plan, inp, out, batch);
+}
+
+/**
+ * \brief  stream as mTranspose_stream() real single precision matrices using
+ *         a plan created by mTranspose_plan_r()
+ */
+fpga_t mTranspose_stream_r(fpga_plan_t *plan, float *inp, float *out, int batch){
+  fpga_t mTranspose_time = {0.0, 0.0, 0.0, 0};
+
+  if(plan == NULL || plan->elem_sz != sizeof(float)){
+    return mTranspose_time;
+  }
+  return plan_stream(plan, inp, out, batch);
+}
+
+/**
+ * \brief  stream as mTranspose_stream() half precision matrices using a plan
+ *         created by mTranspose_plan_h()
+ */
+fpga_t mTranspose_stream_h(fpga_plan_t *plan, half_t *inp, half_t *out, int batch){
+  fpga_t mTranspose_time = {0.0, 0.0, 0.0, 0};
+
+  if(plan == NULL || plan->elem_sz != sizeof(half_t)){
+    return mTranspose_time;
+  }
+  return plan_stream(plan, inp, out, batch);
+}
+
+/**
+ * \brief  stream as mTranspose_stream() bfloat16 matrices using a plan
+ *         created by mTranspose_plan_bf()
+ */
+fpga_t mTranspose_stream_bf(fpga_plan_t *plan, bf16_t *inp, bf16_t *out, int batch){
+  fpga_t mTranspose_time = {0.0, 0.0, 0.0, 0};
+
+  if(plan == NULL || plan->elem_sz != sizeof(bf16_t)){
+    return mTranspose_time;
+  }
+  return plan_stream(plan, inp, out, batch);
+}
+
+/**
+ * \brief  stream chunks of matrices of the element size of the plan
+ */
+static fpga_t plan_stream(fpga_plan_t *plan, void *inp, void *out, int batch){
+  fpga_t mTranspose_time = {0.0, 0.0, 0.0, 0};
+  cl_int status = 0;
+
+  if(plan == NULL || inp == NULL || out == NULL || batch <= 0){
+    return mTranspose_time;
+  }
+
+  if(plan->banks > 0){
+    fprintf(stderr, "Streaming is not supported by banked bitstreams\n");
+    return mTranspose_time;
+  }
+
+  if(plan->persistent){
+    fprintf(stderr, "Streaming is not supported by persistent bitstreams\n");
+    return mTranspose_time;
+  }
+
+  async_drain(plan);
+  if(alloc_second_pair(plan)){
+    return mTranspose_time;
+  }
+
+  fpga_device_t *dev = plan->dev;
+  const size_t mat_sz = (size_t)plan->N * plan->N;
+  const int chunks = (batch + plan->batch - 1) / plan->batch;
+
+  // last events that used each pair of buffers
+  cl_event fetch_ev[2] = {NULL, NULL}, read_ev[2] = {NULL, NULL};
+
+  double start = getTimeinMilliSec();
+  for(int k = 0; k < chunks; k++){
+    const int b = k & 1;
+    const int cur = (k == chunks - 1) ? (batch - (k * plan->batch)) : plan->batch;
+    const size_t offset = plan->elem_sz * k * plan->batch * mat_sz;
+    const size_t chunk_sz = plan->elem_sz * cur * mat_sz;
+    cl_event write_ev, store_ev;
+
+    // input buffer can be overwritten once the fetch of chunk k-2 is done
+    status = clEnqueueWriteBuffer(dev->queue4, plan->d_inData[b], CL_FALSE, 0, chunk_sz, (char *)inp + offset, fetch_ev[b] ? 1 : 0, fetch_ev[b] ? &fetch_ev[b] : NULL, &write_ev);
+    checkError(status, "Failed to copy data to device");
+
+    if(fetch_ev[b])
+      clReleaseEvent(fetch_ev[b]);
+
+    // output buffer can be overwritten once the read of chunk k-2 is done
+    launch_kernels(plan, cur, plan->d_inData[b], plan->d_outData[b], &write_ev, read_ev[b] ? &read_ev[b] : NULL, &fetch_ev[b], NULL, &store_ev);
+
+    if(read_ev[b])
+      clReleaseEvent(read_ev[b]);
+
+    status = clEnqueueReadBuffer(dev->queue5, plan->d_outData[b], CL_FALSE, 0, chunk_sz, (char *)out + offset, 1, &store_ev, &read_ev[b]);
+    checkError(status, "Failed to read data from device");
+
+    clReleaseEvent(write_ev);
+    clReleaseEvent(store_ev);
+
+    // submit the chunk to the device before preparing the next
+    clFlush(dev->queue4);
+    clFlush(dev->queue1);
+    clFlush(dev->queue2);
+    clFlush(dev->queue3);
+    clFlush(dev->queue5);
+  }
+
+  status = clFinish(dev->queue5);
+  checkError(status, "failed to finish");
+  status = clFinish(dev->queue3);
+  checkError(status, "failed to finish");
+
+  mTranspose_time.exec_t = getTimeinMilliSec() - start;
+
+  for(int i = 0; i < 2; i++){
+    if(fetch_ev[i])
+      clReleaseEvent(fetch_ev[i]);
+    if(read_ev[i])
+      clReleaseEvent(read_ev[i]);
+  }
+
+  mTranspose_time.valid = 1;
+  return mTranspose_time;
+}
+
+/**
+ * \brief  offset of the page of a mapping an offset is in
+ */
+static size_t page_floor(size_t off){
+  const size_t page = (size_t)sysconf(_SC_PAGESIZE);
+  return off - (off % page);
+}
+
+/**
+ * \brief  advise the kernel on the pages of [off, off + len) of a mapping
+ */
+static void file_advise(char *base, size_t off, size_t len, size_t total, int advice){
+  if(off >= total || len == 0)
+    return;
+  if(off + len > total)
+    len = total - off;
+
+  size_t start = page_floor(off);
+  madvise(base + start, len + (off - start), advice);
+}
+
+/**
+ * \brief  write back the pages of an output window and drop them
+ */
+static void file_release_out(char *base, size_t off, size_t len, size_t total){
+  if(off >= total || len == 0)
+    return;
+  if(off + len > total)
+    len = total - off;
+
+  // pages shared with the previous window are dropped with the next window
+  size_t start = page_floor(off);
+  size_t end = (off + len == total) ? total : page_floor(off + len);
+  if(end <= start)
+    return;
+
+  msync(base + start, end - start, MS_SYNC);
+  madvise(base + start, end - start, MADV_DONTNEED);
+}
+
+/**
+ * \brief  transpose every N x N matrix of a file into another, both mapped
+ *         and streamed through the plan in windows of FILE_WINDOW chunks.
+ *         While a window is streamed, the next is read ahead from disk. Input
+ *         windows are dropped once streamed, output windows written back and
+ *         dropped one window later, so at most two windows of each file are
+ *         resident whatever the size of the files.
+ * \param  plan     : plan created using mTranspose_plan() or its typed
+ *                    variants, batch is the chunk size
+ * \param  in_path  : file of matrices of the element type of the plan
+ * \param  out_path : file created or truncated to the size of the input
+ * \param  file     : matrices and windows of the files if not NULL
+ * \retval fpga_t : exec_t is the end-to-end time in milliseconds including
+ *                  disk and PCIe transfers
+ */
+fpga_t mTranspose_file(fpga_plan_t *plan, const char *in_path, const char *out_path, fpga_file_t *file){
+  fpga_t mTranspose_time = {0.0, 0.0, 0.0, 0};
+  char *inp = MAP_FAILED, *out = MAP_FAILED;
+  int in_fd = -1, out_fd = -1;
+  size_t total = 0;
+  struct stat st;
+
+  if(plan == NULL || in_path == NULL || out_path == NULL){
+    return mTranspose_time;
+  }
+
+  if(plan->banks > 0){
+    fprintf(stderr, "Streaming is not supported by banked bitstreams\n");
+    return mTranspose_time;
+  }
+
+  if(plan->persistent){
+    fprintf(stderr, "Streaming is not supported by persistent bitstreams\n");
+    return mTranspose_time;
+  }
+
+  const size_t mat_bytes = plan->elem_sz * plan->N * plan->N;
+  const size_t window = (size_t)plan->batch * FILE_WINDOW;
+  const size_t window_bytes = window * mat_bytes;
+
+  in_fd = open(in_path, O_RDONLY);
+  if(in_fd < 0 || fstat(in_fd, &st) != 0 || st.st_size == 0 || (size_t)st.st_size % mat_bytes != 0){
+    fprintf(stderr, "%s is not a file of %d x %d matrices\n", in_path, plan->N, plan->N);
+    goto cleanup;
+  }
+  total = (size_t)st.st_size;
+  const size_t matrices = total / mat_bytes;
+
+  out_fd = open(out_path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if(out_fd < 0 || ftruncate(out_fd, (off_t)total) != 0){
+    fprintf(stderr, "Failed to create %s\n", out_path);
+    goto cleanup;
+  }
+
+  inp = mmap(NULL, total, PROT_READ, MAP_PRIVATE, in_fd, 0);
+  out = mmap(NULL, total, PROT_READ | PROT_WRITE, MAP_SHARED, out_fd, 0);
+  if(inp == MAP_FAILED || out == MAP_FAILED){
+    fprintf(stderr, "Failed to map %s and %s\n", in_path, out_path);
+    goto cleanup;
+  }
+  madvise(inp, total, MADV_SEQUENTIAL);
+
+  const size_t windows = (matrices + window - 1) / window;
+  double start = getTimeinMilliSec();
+
+  file_advise(inp, 0, window_bytes, total, MADV_WILLNEED);
+  for(size_t w = 0; w < windows; w++){
+    const size_t off = w * window_bytes;
+    const int cur = (int)((w == windows - 1) ? (matrices - (w * window)) : window);
+
+    // disk reads of the next window overlap with this one on the device
+    file_advise(inp, off + window_bytes, window_bytes, total, MADV_WILLNEED);
+
+    fpga_t timing = plan_stream(plan, inp + off, out + off, cur);
+    if(timing.valid != 1)
+      goto cleanup;
+
+    file_advise(inp, off, window_bytes, total, MADV_DONTNEED);
+    msync(out + page_floor(off), (off - page_floor(off)) + ((size_t)cur * mat_bytes), MS_ASYNC);
+    if(w > 0)
+      file_release_out(out, off - window_bytes, window_bytes, total);
+  }
+  file_release_out(out, (windows - 1) * window_bytes, window_bytes, total);
+
+  mTranspose_time.exec_t = getTimeinMilliSec() - start;
+  mTranspose_time.valid = 1;
+
+  if(file != NULL){
+    file->matrices = matrices;
+    file->window = window;
+    file->windows = windows;
+  }
+
+cleanup:
+  if(inp != MAP_FAILED)
+    munmap(inp, total);
+  if(out != MAP_FAILED)
+    munmap(out, total);
+  if(in_fd >= 0)
+    close(in_fd);
+  if(out_fd >= 0)
+    close(out_fd);
+  return mTranspose_time;
+}
+
+/**
+ * \brief  transpose a batch of matrices using the resources of a plan
+ * \param  plan  : plan created using mTranspose_plan()
+ * \param  inp   : pointer to input matrices
+ * \param  out   : pointer to output matrices
+ * \param  batch : number of matrices to transpose, at most the batch of the plan
+ * \retval fpga_t : time taken in milliseconds for data transfers and execution
+ */
+fpga_t mTranspose_execute(fpga_plan_t *plan, float2 *inp, float2 *out, int batch){
+  fpga_t mTranspose_time = {0.0, 0.0, 0.0, 0};
+
+  if(plan == NULL || plan->elem_sz != sizeof(float2)){
+    return mTranspose_time;
+  }
+  return plan_execute(plan, inp, out, batch);
+}
+
+/**
+ * \brief  transpose a batch of matrices in place using the resources of a
+ *         plan, on a single device buffer if created by
+ *         mTranspose_plan_inplace()
+ * \param  data  : pointer to the matrices, overwritten by their transpose
+ */
+fpga_t mTranspose_execute_inplace(fpga_plan_t *plan, float2 *data, int batch){
+  return mTranspose_execute(plan, data, data, batch);
+}
+
+/**
+ * \brief  transpose as mTranspose_execute() double precision complex
+ *         matrices using a plan created by mTranspose_plan_d()
+ */
+fpga_t mTranspose_execute_d(fpga_plan_t *plan, double2 *inp, double2 *out, int batch){
+  fpga_t mTranspose_time = {0.0, 0.0, 0.0, 0};
+
+  if(plan == NULL || plan->elem_sz != sizeof(double2)){
+    return mTranspose_time;
+  }
+  return plan_execute(plan, inp, out, batch);
+}
+
+/**
+ * \brief  transpose as mTranspose_execute() real single precision matrices
+ *         using a plan created by mTranspose_plan_r()
+ */
+fpga_t mTranspose_execute_r(fpga_plan_t *plan, float *inp, float *out, int batch){
+  fpga_t mTranspose_time = {0.0, 0.0, 0.0, 0};
+
+  if(plan == NULL || plan->elem_sz != sizeof(float)){
+    return mTranspose_time;
+  }
+  return plan_execute(plan, inp, out, batch);
+}
+
+/**
+ * \brief  transpose as mTranspose_execute() half precision matrices using a
+ *         plan created by mTranspose_plan_h()
+ */
+fpga_t mTranspose_execute_h(fpga_plan_t *plan, half_t *inp, half_t *out, int batch){
+  fpga_t mTranspose_time = {0.0, 0.0, 0.0, 0};
+
+  if(plan == NULL || plan->elem_sz != sizeof(half_t)){
+    return mTranspose_time;
+  }
+  return plan_execute(plan, inp, out, batch);
+}
+
+/**
+ * \brief  transpose as mTranspose_execute() bfloat16 matrices using a plan
+ *         created by mTranspose_plan_bf()
+ */
+fpga_t mTranspose_execute_bf(fpga_plan_t *plan, bf16_t *inp, bf16_t *out, int batch){
+  fpga_t mTranspose_time = {0.0, 0.0, 0.0, 0};
+
+  if(plan == NULL || plan->elem_sz != sizeof(bf16_t)){
+    return mTranspose_time;
+  }
+  return plan_execute(plan, inp, out, batch);
+}
+
+/**
+ * \brief  transpose a batch of matrices of the element size of the plan
+ */
+static fpga_t plan_execute(fpga_plan_t *plan, void *inp, void *out, int batch){
+  fpga_t mTranspose_time = {0.0, 0.0, 0.0, 0};
+  cl_int status = 0;
+
+  if(plan == NULL || inp == NULL || out == NULL || batch <= 0 || batch > plan->batch){
+    return mTranspose_time;
+  }
+
+  if(plan->banks > 0){
+    return bank_execute(plan, inp, out, batch);
+  }
+
+  if(plan->persistent){
+    return persist_execute(plan, inp, out, batch);
+  }
+
+  async_drain(plan);
+
+  fpga_device_t *dev = plan->dev;
+  const int N = plan->N;
+  size_t buf_sz = plan->elem_sz * batch * N * N;
+
+  // kernels fetch and store shared virtual memory without copies
+  host_buf_t *in_buf = host_buf_find(inp, buf_sz), *out_buf = host_buf_find(out, buf_sz);
+  if(in_buf != NULL && out_buf != NULL && in_buf->pinned == NULL && out_buf->pinned == NULL){
+    return svm_execute(plan, inp, out, batch);
+  }
+
+ // Copy data from host to device
+  mTranspose_time.pcie_write_t = getTimeinMilliSec();
+
+  cl_event write_ev, fetch_ev, transpose_ev, store_ev, read_ev;
+  status = clEnqueueWriteBuffer(dev->queue1, plan->d_inData[0], CL_TRUE, 0, buf_sz, inp, 0, NULL, &write_ev);
+
+  mTranspose_time.pcie_write_t = getTimeinMilliSec() - mTranspose_time.pcie_write_t;
+  checkError(status, "Failed to copy data to device");
+
+  double start = getTimeinMilliSec();
+  launch_kernels(plan, batch, plan->d_inData[0], plan->d_outData[0], NULL, NULL, &fetch_ev, &transpose_ev, &store_ev);
+
+  // Wait for all command queues to complete pending events
+  status = clFinish(dev->queue1);
+  checkError(status, "failed to finish");
+  status = clFinish(dev->queue2);
+  checkError(status, "failed to finish");
+  status = clFinish(dev->queue3);
+  checkError(status, "failed to finish");
+
+  double stop = getTimeinMilliSec();
+  mTranspose_time.exec_t = stop - start;
+
+  mTranspose_time.pcie_read_t = getTimeinMilliSec();
+
+  status = clEnqueueReadBuffer(dev->queue1, plan->d_outData[0], CL_TRUE, 0, buf_sz, out, 0, NULL, &read_ev);
+
+  mTranspose_time.pcie_read_t = getTimeinMilliSec() - mTranspose_time.pcie_read_t;
+  checkError(status, "Failed to read data from device");
+
+  // device timings replace the host ones unless profiling is unavailable
+  profile_events(&plan->profile, write_ev, fetch_ev, transpose_ev, store_ev, read_ev);
+  if(plan->profile.valid){
+    mTranspose_time.pcie_write_t = plan->profile.write.end - plan->profile.write.start;
+    mTranspose_time.exec_t = plan->profile.pipeline_t;
+    mTranspose_time.pcie_read_t = plan->profile.read.end - plan->profile.read.start;
+  }
+
+  clReleaseEvent(write_ev);
+  clReleaseEvent(fetch_ev);
+  clReleaseEvent(transpose_ev);
+  clReleaseEvent(store_ev);
+  clReleaseEvent(read_ev);
+
+  mTranspose_time.valid = 1;
+  return mTranspose_time;
+}
+
+// Tile of a rows x cols matrix k, at most T x T
+typedef struct {
+  size_t k, row, col;
+  size_t h, w;
+} tile_t;
+
+/**
+ * \brief  t-th tile of a batch of rows x cols matrices in row major order
+ */
+static tile_t get_tile(size_t t, size_t rows, size_t cols, size_t T){
+  const size_t tile_rows = (rows + T - 1) / T, tile_cols = (cols + T - 1) / T;
+  tile_t tile;
+
+  tile.k = t / (tile_rows * tile_cols);
+  tile.row = ((t / tile_cols) % tile_rows) * T;
+  tile.col = (t % tile_cols) * T;
+  tile.h = (rows - tile.row) < T ? (rows - tile.row) : T;
+  tile.w = (cols - tile.col) < T ? (cols - tile.col) : T;
+  return tile;
+}
+
+/**
+ * \brief  transpose a batch of rows x cols matrices using tiles of the plan's
+ *         N x N. Tiles are written from and read back to their positions in
+ *         the matrices using rectangular transfers, without copies on the
+ *         host. Partial tiles at the edges are padded to N x N if at least
+ *         half a tile long in both dimensions, smaller remainders are
+ *         transposed on the cpu while the FPGA is busy.
+ *
+ *         Chunks of the plan's batch of tiles alternate between two pairs of
+ *         device buffers, overlapping the transfers of a chunk with the
+ *         execution of the previous one. Matrices are hence only limited by
+ *         host memory, not by the N of the bitstream nor device memory.
+ * \param  plan   : plan created using mTranspose_plan(), batch is the number
+ *                  of tiles per execution
+ * \param  rows   : number of rows of an input matrix
+ * \param  cols   : number of columns of an input matrix
+ * \param  inp    : pointer to input matrices
+ * \param  out    : pointer to cols x rows output matrices
+ * \param  batch  : number of matrices
+ * \param  tiling : distribution of the points, ignored if NULL
+ * \retval fpga_t : exec_t is the end-to-end time in milliseconds including
+ *                  all PCIe transfers
+ */
+fpga_t mTranspose_rect(fpga_plan_t *plan, int rows, int cols, float2 *inp, float2 *out, int batch, fpga_tiling_t *tiling){
+  fpga_t mTranspose_time = {0.0, 0.0, 0.0, 0};
+  fpga_tiling_t count = {0, 0, 0, 0};
+  cl_int status = 0;
+
+  if(plan == NULL || plan->elem_sz != sizeof(float2) || inp == NULL || out == NULL || rows <= 0 || cols <= 0 || batch <= 0){
+    return mTranspose_time;
+  }
+
+  if(plan->banks > 0){
+    fprintf(stderr, "Rectangular matrices are not supported by banked bitstreams\n");
+    return mTranspose_time;
+  }
+
+  if(plan->persistent){
+    fprintf(stderr, "Rectangular matrices are not supported by persistent bitstreams\n");
+    return mTranspose_time;
+  }
+
+  async_drain(plan);
+  if(alloc_second_pair(plan)){
+    return mTranspose_time;
+  }
+
+  // tiles in the device buffers of the current execution
+  tile_t *tiles = (tile_t *)malloc(sizeof(tile_t) * plan->batch);
+  if(tiles == NULL){
+    return mTranspose_time;
+  }
+
+  fpga_device_t *dev = plan->dev;
+  const size_t T = plan->N;
+  const size_t tile_rows = (rows + T - 1) / T, tile_cols = (cols + T - 1) / T;
+  const size_t mat_sz = (size_t)rows * cols;
+  const size_t num_tiles = batch * tile_rows * tile_cols;
+  int slot = 0;
+
+  count.points = mat_sz * batch;
+
+  double start = getTimeinMilliSec();
+
+  // last events that used each pair of buffers
+  cl_event fetch_ev[2] = {NULL, NULL}, read_ev[2] = {NULL, NULL};
+  int chunk = 0;
+
+  // stream chunks of tiles through alternating buffers, as mTranspose_stream
+  for(size_t t = 0; t < num_tiles; t++){
+    tile_t tile = get_tile(t, rows, cols, T);
+    const int b = chunk & 1;
+
+    if(tile.h >= T / 2 && tile.w >= T / 2){
+      // batch of matrices viewed as a (batch * rows) x cols matrix
+      size_t buf_origin[3] = {0, slot * T, 0};
+      size_t in_origin[3] = {tile.col * sizeof(float2), (tile.k * rows) + tile.row, 0};
+      size_t in_region[3] = {tile.w * sizeof(float2), tile.h, 1};
+
+      // input buffer can be overwritten once the fetch of chunk - 2 is done
+      status = clEnqueueWriteBufferRect(dev->queue4, plan->d_inData[b], CL_FALSE, buf_origin, in_origin, in_region, T * sizeof(float2), 0, cols * sizeof(float2), 0, inp, fetch_ev[b] ? 1 : 0, fetch_ev[b] ? &fetch_ev[b] : NULL, NULL);
+      checkError(status, "Failed to copy tile to device");
+
+      count.fpga_points += T * T;
+      count.padded_points += (T * T) - (tile.h * tile.w);
+      tiles[slot++] = tile;
+    }
+
+    if(slot == plan->batch || (slot > 0 && t == num_tiles - 1)){
+      cl_event write_ev, store_ev;
+
+      // marks the completion of the writes of the chunk on the in-order queue
+      status = clEnqueueMarkerWithWaitList(dev->queue4, 0, NULL, &write_ev);
+      checkError(status, "Failed to enqueue marker");
+
+      if(fetch_ev[b])
+        clReleaseEvent(fetch_ev[b]);
+
+      // output buffer can be overwritten once the reads of chunk - 2 are done
+      launch_kernels(plan, slot, plan->d_inData[b], plan->d_outData[b], &write_ev, read_ev[b] ? &read_ev[b] : NULL, &fetch_ev[b], NULL, &store_ev);
+
+      if(read_ev[b])
+        clReleaseEvent(read_ev[b]);
+      read_ev[b] = NULL;
+
+      // each tile to its mirrored block, output is a (batch * cols) x rows matrix
+      for(int s = 0; s < slot; s++){
+        size_t buf_origin[3] = {0, s * T, 0};
+        size_t out_origin[3] = {tiles[s].row * sizeof(float2), (tiles[s].k * cols) + tiles[s].col, 0};
+        size_t out_region[3] = {tiles[s].h * sizeof(float2), tiles[s].w, 1};
+
+        status = clEnqueueReadBufferRect(dev->queue5, plan->d_outData[b], CL_FALSE, buf_origin, out_origin, out_region, T * sizeof(float2), 0, rows * sizeof(float2), 0, out, 1, &store_ev, NULL);
+        checkError(status, "Failed to read tile from device");
+      }
+
+      status = clEnqueueMarkerWithWaitList(dev->queue5, 0, NULL, &read_ev[b]);
+      checkError(status, "Failed to enqueue marker");
+
+      clReleaseEvent(write_ev);
+      clReleaseEvent(store_ev);
+
+      // submit the chunk to the device before preparing the next
+      clFlush(dev->queue4);
+      clFlush(dev->queue1);
+      clFlush(dev->queue2);
+      clFlush(dev->queue3);
+      clFlush(dev->queue5);
+      slot = 0;
+      chunk++;
+    }
+  }
+
+  // remainders on the cpu overlap with the FPGA
+  for(size_t t = 0; t < num_tiles; t++){
+    tile_t tile = get_tile(t, rows, cols, T);
+
+    if(tile.h < T / 2 || tile.w < T / 2){
+      const float2 *src = &inp[(tile.k * mat_sz) + (tile.row * cols) + tile.col];
+      float2 *dst = &out[(tile.k * mat_sz) + (tile.col * rows) + tile.row];
+
+      cpu_transpose_block(src, cols, dst, rows, tile.h, tile.w);
+      count.cpu_points += tile.h * tile.w;
+    }
+  }
+
+  status = clFinish(dev->queue5);
+  checkError(status, "failed to finish");
+  status = clFinish(dev->queue3);
+  checkError(status, "failed to finish");
+
+  mTranspose_time.exec_t = getTimeinMilliSec() - start;
+  free(tiles);
+
+  for(int i = 0; i < 2; i++){
+    if(fetch_ev[i])
+      clReleaseEvent(fetch_ev[i]);
+    if(read_ev[i])
+      clReleaseEvent(read_ev[i]);
+  }
+
+  if(tiling != NULL)
+    *tiling = count;
+
+  mTranspose_time.valid = 1;
+  return mTranspose_time;
+}
+
+/**
+ * \brief  transpose matrices in shared virtual memory, read and written by
+ *         the kernels over PCIe. Transfers are part of exec_t.
+ */
+static fpga_t svm_execute(fpga_plan_t *plan, void *inp, void *out, int batch){
+  fpga_t mTranspose_time = {0.0, 0.0, 0.0, 0};
+  cl_int status = 0;
+  fpga_device_t *dev = plan->dev;
+
+  double start = getTimeinMilliSec();
+
+  status = clSetKernelArgSVMPointer(plan->fetch_kernel, 0, inp);
+  checkError(status, "Failed to set fetch kernel svm arg 0");
+  status = clSetKernelArgSVMPointer(plan->store_kernel, 0, out);
+  checkError(status, "Failed to set store kernel svm arg 0");
+
+  cl_event fetch_ev, transpose_ev, store_ev;
+  enqueue_kernels(plan, batch, NULL, NULL, &fetch_ev, &transpose_ev, &store_ev);
+
+  status = clFinish(dev->queue1);
+  checkError(status, "failed to finish");
+  status = clFinish(dev->queue2);
+  checkError(status, "failed to finish");
+  status = clFinish(dev->queue3);
+  checkError(status, "failed to finish");
+
+  mTranspose_time.exec_t = getTimeinMilliSec() - start;
+
+  profile_events(&plan->profile, NULL, fetch_ev, transpose_ev, store_ev, NULL);
+  if(plan->profile.valid){
+    mTranspose_time.exec_t = plan->profile.pipeline_t;
+  }
+
+  clReleaseEvent(fetch_ev);
+  clReleaseEvent(transpose_ev);
+  clReleaseEvent(store_ev);
+  mTranspose_time.valid = 1;
+  return mTranspose_time;
+}
+
+/**
+ * \brief  set the kernel arguments and enqueue the fetch, transpose and store
+ *         kernels of a plan to their respective queues
+ * \param  plan       : plan whose kernels are launched
+ * \param  batch      : number of matrices to transpose
+ * \param  d_in       : device buffer read by the fetch kernel
+ * \param  d_out      : device buffer written by the store kernel
+ * \param  fetch_wait : event to complete before fetching, NULL if none
+ * \param  store_wait : event to complete before storing, NULL if none
+ * \param  fetch_done : event of the fetch kernel returned if not NULL
+ * \param  transpose_done : event of the transpose kernel returned if not NULL
+ * \param  store_done : event of the store kernel returned if not NULL
+ */
+static void launch_kernels(fpga_plan_t *plan, int batch, cl_mem d_in, cl_mem d_out, cl_event *fetch_wait, cl_event *store_wait, cl_event *fetch_done, cl_event *transpose_done, cl_event *store_done){
+  cl_int status = 0;
+
+  // kernel args are captured at enqueue, therefore can be changed per launch
+  status = clSetKernelArg(plan->fetch_kernel, 0, sizeof(cl_mem), (void *)&d_in);
+  checkError(status, "Failed to set fetch kernel arg 0");
+  status = clSetKernelArg(plan->store_kernel, 0, sizeof(cl_mem), (void *)&d_out);
+  checkError(status, "Failed to set store kernel arg 0");
+
+  enqueue_kernels(plan, batch, fetch_wait, store_wait, fetch_done, transpose_done, store_done);
+}
+
+/**
+ * \brief  enqueue the kernels of a plan whose buffers are already set
+ */
+static void enqueue_kernels(fpga_plan_t *plan, int batch, cl_event *fetch_wait, cl_event *store_wait, cl_event *fetch_done, cl_event *transpose_done, cl_event *store_done){
+  cl_int status = 0;
+  fpga_device_t *dev = plan->dev;
+  const int N = plan->N;
+  const int points = plan->points;
+
+  status = clSetKernelArg(plan->fetch_kernel, 1, sizeof(cl_int), (void*)&batch);
+  checkError(status, "Failed to set fetch kernel arg 1");
+
+  status = clSetKernelArg(plan->transpose_kernel, 0, sizeof(cl_int), (void*)&batch);
+  checkError(status, "Failed to set transpose kernel arg 0");
+
+  status = clSetKernelArg(plan->store_kernel, 1, sizeof(cl_int), (void*)&batch);
+  checkError(status, "Failed to set store kernel arg 1");
+
+  cl_uint num_fetch_wait = fetch_wait ? 1 : 0;
+  cl_uint num_store_wait = store_wait ? 1 : 0;
+
+  if(plan->isND){
+    size_t lws_transfer[] = {N};
+    size_t gws_transfer[] = {batch * N * N / points};
+
+    status = clEnqueueNDRangeKernel(dev->queue1, plan->fetch_kernel, 1, 0, gws_transfer, lws_transfer, num_fetch_wait, fetch_wait, fetch_done);
+    checkError(status, "Failed to launch kernel");
+
+    size_t lws_transpose_kernel[] = {N * N / points};
+    size_t gws_transpose_kernel[] = {batch * N * N / points};
+    status = clEnqueueNDRangeKernel(dev->queue2, plan->transpose_kernel, 1, 0, gws_transpose_kernel, lws_transpose_kernel, 0, NULL, transpose_done);
+    checkError(status, "Failed to launch kernel");
+
+    status = clEnqueueNDRangeKernel(dev->queue3, plan->store_kernel, 1, 0, gws_transfer, lws_transfer, num_store_wait, store_wait, store_done);
+    checkError(status, "Failed to launch kernel");
+  }
+  else{
+    status = clEnqueueTask(dev->queue1, plan->fetch_kernel, num_fetch_wait, fetch_wait, fetch_done);
+    checkError(status, "Failed to launch fetch kernel");
+
+    status = clEnqueueTask(dev->queue2, plan->transpose_kernel, 0, NULL, transpose_done);
+    checkError(status, "Failed to launch transpose kernel");
+
+    status = clEnqueueTask(dev->queue3, plan->store_kernel, num_store_wait, store_wait, store_done);
+    checkError(status, "Failed to launch store kernel");
+  }
+}
+
+/**
+ * \brief  allocate the second pair of device buffers of a plan on first use
+ * \retval 0 if allocated
+ */
+static int alloc_second_pair(fpga_plan_t *plan){
+  // the next chunk would be written over outputs not yet read
+  if(plan->inplace){
+    fprintf(stderr, "Overlapping transfers with execution is not supported by in place plans\n");
+    return 1;
+  }
+
+  if(plan->d_inData[1] == NULL)
+    plan->d_inData[1] = dev_buf_acquire(plan->buf_sz, CL_CHANNEL_1_INTELFPGA);
+  if(plan->d_outData[1] == NULL)
+    plan->d_outData[1] = dev_buf_acquire(plan->buf_sz, CL_CHANNEL_2_INTELFPGA);
+
+  return (plan->d_inData[1] == NULL || plan->d_outData[1] == NULL) ? 1 : 0;
+}
+
+/**
+ * \brief  create the kernels of every pipeline of a banked bitstream and
+ *         split the batch of the plan between them. Input of pipeline b is
+ *         placed in bank b, its output in the next bank, so that every bank
+ *         is read by one pipeline and written by another. Replicated
+ *         pipelines wrap around the banks.
+ * \retval 0 if created
+ */
+static int bank_create(fpga_plan_t *plan){
+  cl_int status = 0;
+  fpga_device_t *dev = plan->dev;
+  const char *stage[3] = {"fetch", "transpose", "store"};
+  char name[32];
+
+  plan->banks = dev->banks;
+  plan->bank_batch = (plan->batch + dev->banks - 1) / dev->banks;
+  size_t bank_sz = plan->elem_sz * plan->bank_batch * plan->N * plan->N;
+
+  for(int b = 0; b < dev->banks; b++){
+    plan->d_bankIn[b] = dev_buf_acquire(bank_sz, bank_channel[b % dev->mem_banks]);
+    plan->d_bankOut[b] = plan->inplace ? plan->d_bankIn[b] : dev_buf_acquire(bank_sz, bank_channel[(b + 1) % dev->mem_banks]);
+    if(plan->d_bankIn[b] == NULL || plan->d_bankOut[b] == NULL)
+      return 1;
+
+    for(int k = 0; k < 3; k++){
+      snprintf(name, sizeof(name), "%s%d", stage[k], b);
+      plan->bank_kernels[b][k] = clCreateKernel(dev->program, name, &status);
+      checkError(status, "Failed to create bank kernel");
+    }
+  }
+  return 0;
+}
+
+/**
+ * \brief  transpose a batch on the pipelines of a banked bitstream, each
+ *         pipeline a contiguous slice of the batch, all running concurrently
+ */
+static fpga_t bank_execute(fpga_plan_t *plan, void *inp, void *out, int batch){
+  fpga_t mTranspose_time = {0.0, 0.0, 0.0, 0};
+  cl_int status = 0;
+  fpga_device_t *dev = plan->dev;
+
+  const size_t mat_bytes = plan->elem_sz * plan->N * plan->N;
+  const int slice = (batch + plan->banks - 1) / plan->banks;
+  int count[MAX_PIPELINES];
+
+  for(int b = 0; b < plan->banks; b++){
+    int left = batch - (b * slice);
+    count[b] = (left < 0) ? 0 : ((left < slice) ? left : slice);
+  }
+
+  mTranspose_time.pcie_write_t = getTimeinMilliSec();
+  for(int b = 0; b < plan->banks && count[b] > 0; b++){
+    status = clEnqueueWriteBuffer(dev->bank_queue[b][0], plan->d_bankIn[b], CL_FALSE, 0, count[b] * mat_bytes, (char *)inp + (b * slice * mat_bytes), 0, NULL, NULL);
+    checkError(status, "Failed to copy data to device");
+  }
+  for(int b = 0; b < plan->banks && count[b] > 0; b++){
+    status = clFinish(dev->bank_queue[b][0]);
+    checkError(status, "failed to finish");
+  }
+  mTranspose_time.pcie_write_t = getTimeinMilliSec() - mTranspose_time.pcie_write_t;
+
+  double start = getTimeinMilliSec();
+  for(int b = 0; b < plan->banks && count[b] > 0; b++){
+    cl_kernel *kernel = plan->bank_kernels[b];
+
+    status = clSetKernelArg(kernel[0], 0, sizeof(cl_mem), (void *)&plan->d_bankIn[b]);
+    checkError(status, "Failed to set fetch kernel arg 0");
+    status = clSetKernelArg(kernel[0], 1, sizeof(cl_int), (void*)&count[b]);
+    checkError(status, "Failed to set fetch kernel arg 1");
+    status = clSetKernelArg(kernel[1], 0, sizeof(cl_int), (void*)&count[b]);
+    checkError(status, "Failed to set transpose kernel arg 0");
+    status = clSetKernelArg(kernel[2], 0, sizeof(cl_mem), (void *)&plan->d_bankOut[b]);
+    checkError(status, "Failed to set store kernel arg 0");
+    status = clSetKernelArg(kernel[2], 1, sizeof(cl_int), (void*)&count[b]);
+    checkError(status, "Failed to set store kernel arg 1");
+
+    for(int k = 0; k < 3; k++){
+      status = clEnqueueTask(dev->bank_queue[b][k], kernel[k], 0, NULL, NULL);
+      checkError(status, "Failed to launch bank kernel");
+    }
+  }
+  for(int b = 0; b < plan->banks && count[b] > 0; b++){
+    for(int k = 0; k < 3; k++){
+      status = clFinish(dev->bank_queue[b][k]);
+      checkError(status, "failed to finish");
+    }
+  }
+  mTranspose_time.exec_t = getTimeinMilliSec() - start;
+
+  mTranspose_time.pcie_read_t = getTimeinMilliSec();
+  for(int b = 0; b < plan->banks && count[b] > 0; b++){
+    status = clEnqueueReadBuffer(dev->bank_queue[b][2], plan->d_bankOut[b], CL_FALSE, 0, count[b] * mat_bytes, (char *)out + (b * slice * mat_bytes), 0, NULL, NULL);
+    checkError(status, "Failed to read data from device");
+  }
+  for(int b = 0; b < plan->banks && count[b] > 0; b++){
+    status = clFinish(dev->bank_queue[b][2]);
+    checkError(status, "failed to finish");
+  }
+  mTranspose_time.pcie_read_t = getTimeinMilliSec() - mTranspose_time.pcie_read_t;
+
+  mTranspose_time.valid = 1;
+  return mTranspose_time;
+}
+
+/**
+ * \brief  launch the fetch and store kernels of a persistent bitstream on the
+ *         buffers of the plan, queue2 and 3 running them until stopped by
+ *         mTranspose_destroy(). queue1 is left to the transfers and doorbell.
+ * \retval 0 if launched
+ */
+static int persist_create(fpga_plan_t *plan){
+  cl_int status = 0;
+  fpga_device_t *dev = plan->dev;
+  cl_int doorbell[3] = {0, 0, 0};  // seq, offset, batch
+
+  plan->d_doorbell = clCreateBuffer(context, CL_MEM_READ_WRITE, sizeof(doorbell), NULL, &status);
+  checkError(status, "Failed to allocate doorbell buffer");
+  plan->d_done = clCreateBuffer(context, CL_MEM_READ_WRITE, sizeof(cl_int), NULL, &status);
+  checkError(status, "Failed to allocate done buffer");
+  status = clEnqueueWriteBuffer(dev->queue1, plan->d_doorbell, CL_TRUE, 0, sizeof(doorbell), doorbell, 0, NULL, NULL);
+  checkError(status, "Failed to clear doorbell");
+  status = clEnqueueWriteBuffer(dev->queue1, plan->d_done, CL_TRUE, 0, sizeof(cl_int), &doorbell[0], 0, NULL, NULL);
+  checkError(status, "Failed to clear done");
+
+  plan->fetch_kernel = clCreateKernel(dev->program, "fetch", &status);
+  checkError(status, "Failed to create fetch kernel");
+  plan->store_kernel = clCreateKernel(dev->program, "store", &status);
+  checkError(status, "Failed to create store kernel");
+
+  status = clSetKernelArg(plan->fetch_kernel, 0, sizeof(cl_mem), (void *)&plan->d_inData[0]);
+  checkError(status, "Failed to set fetch kernel arg 0");
+  status = clSetKernelArg(plan->fetch_kernel, 1, sizeof(cl_mem), (void *)&plan->d_doorbell);
+  checkError(status, "Failed to set fetch kernel arg 1");
+  status = clSetKernelArg(plan->store_kernel, 0, sizeof(cl_mem), (void *)&plan->d_outData[0]);
+  checkError(status, "Failed to set store kernel arg 0");
+  status = clSetKernelArg(plan->store_kernel, 1, sizeof(cl_mem), (void *)&plan->d_done);
+  checkError(status, "Failed to set store kernel arg 1");
+
+  status = clEnqueueTask(dev->queue2, plan->fetch_kernel, 0, NULL, NULL);
+  checkError(status, "Failed to launch fetch kernel");
+  status = clEnqueueTask(dev->queue3, plan->store_kernel, 0, NULL, NULL);
+  checkError(status, "Failed to launch store kernel");
+  clFlush(dev->queue2);
+  clFlush(dev->queue3);
+
+  plan->persistent = 1;
+  dev->persist_plan = plan;
+  return 0;
+}
+
+/**
+ * \brief  post a descriptor of batch matrices from offset of the buffers of
+ *         the plan to the persistent kernels and wait until they are stored.
+ *         The sequence number is written last, so that fetch reads a complete
+ *         descriptor once it sees it change. The done word is polled with a
+ *         growing sleep, for at most PERSIST_TIMEOUT_MS.
+ * \retval 0 if stored, 1 if the kernels did not store it in time
+ */
+static int persist_post(fpga_plan_t *plan, int offset, int batch){
+  cl_int status = 0;
+  fpga_device_t *dev = plan->dev;
+  cl_int desc[2] = {offset, batch};
+  cl_int seq = ++plan->seq, done = 0;
+  useconds_t wait = 1;
+
+  if(plan->hung){
+    fprintf(stderr, "Persistent kernels of the plan stopped responding\n");
+    return 1;
+  }
+
+  status = clEnqueueWriteBuffer(dev->queue1, plan->d_doorbell, CL_TRUE, sizeof(cl_int), sizeof(desc), desc, 0, NULL, NULL);
+  checkError(status, "Failed to write descriptor");
+  status = clEnqueueWriteBuffer(dev->queue1, plan->d_doorbell, CL_TRUE, 0, sizeof(cl_int), &seq, 0, NULL, NULL);
+  checkError(status, "Failed to ring doorbell");
+
+  const double deadline = getTimeinMilliSec() + PERSIST_TIMEOUT_MS;
+  while(1){
+    status = clEnqueueReadBuffer(dev->queue1, plan->d_done, CL_TRUE, 0, sizeof(cl_int), &done, 0, NULL, NULL);
+    checkError(status, "Failed to read done");
+    if(done == seq)
+      return 0;
+    if(getTimeinMilliSec() > deadline)
+      break;
+
+    usleep(wait);
+    wait = (wait < PERSIST_MAX_WAIT_US) ? (wait * 2) : PERSIST_MAX_WAIT_US;
+  }
+
+  fprintf(stderr, "Persistent kernels did not store %d matrices in %d ms\n", batch, PERSIST_TIMEOUT_MS);
+  plan->hung = 1;
+  return 1;
+}
+
+/**
+ * \brief  transpose a batch on the persistent kernels of the plan, without
+ *         launching any kernel
+ */
+static fpga_t persist_execute(fpga_plan_t *plan, void *inp, void *out, int batch){
+  fpga_t mTranspose_time = {0.0, 0.0, 0.0, 0};
+  cl_int status = 0;
+  fpga_device_t *dev = plan->dev;
+  size_t buf_sz = plan->elem_sz * batch * plan->N * plan->N;
+
+  mTranspose_time.pcie_write_t = getTimeinMilliSec();
+  status = clEnqueueWriteBuffer(dev->queue1, plan->d_inData[0], CL_TRUE, 0, buf_sz, inp, 0, NULL, NULL);
+  checkError(status, "Failed to copy data to device");
+  mTranspose_time.pcie_write_t = getTimeinMilliSec() - mTranspose_time.pcie_write_t;
+
+  // doorbell until done, no device side profile of kernels never ending
+  double start = getTimeinMilliSec();
+  if(persist_post(plan, 0, batch))
+    return mTranspose_time;
+  mTranspose_time.exec_t = getTimeinMilliSec() - start;
+
+  mTranspose_time.pcie_read_t = getTimeinMilliSec();
+  status = clEnqueueReadBuffer(dev->queue1, plan->d_outData[0], CL_TRUE, 0, buf_sz, out, 0, NULL, NULL);
+  checkError(status, "Failed to read data from device");
+  mTranspose_time.pcie_read_t = getTimeinMilliSec() - mTranspose_time.pcie_read_t;
+
+  mTranspose_time.valid = 1;
+  return mTranspose_time;
+}
+
+/**
+ * \brief  stop the fetch and store kernels of the plan by a negative
+ *         sequence number and wait for them to end
+ */
+static void persist_stop(fpga_plan_t *plan){
+  cl_int status = 0;
+  fpga_device_t *dev = plan->dev;
+  cl_int stop = -1;
+
+  status = clEnqueueWriteBuffer(dev->queue1, plan->d_doorbell, CL_TRUE, 0, sizeof(cl_int), &stop, 0, NULL, NULL);
+  checkError(status, "Failed to ring doorbell");
+  // hung kernels would never end, left to the release of the queues
+  if(!plan->hung){
+    status = clFinish(dev->queue2);
+    checkError(status, "failed to finish");
+    status = clFinish(dev->queue3);
+    checkError(status, "failed to finish");
+  }
+
+  plan->persistent = 0;
+  dev->persist_plan = NULL;
+}
+
+/**
+ * \brief  release the kernels and device buffers of a plan
+ * \param  plan : plan created using mTranspose_plan()
+ */
+void mTranspose_destroy(fpga_plan_t *plan){
+  if(plan == NULL)
+    return;
+
+  async_drain(plan);
+
+  if(plan->persistent)
+    persist_stop(plan);
+  if(plan->d_doorbell)
+    clReleaseMemObject(plan->d_doorbell);
+  if(plan->d_done)
+    clReleaseMemObject(plan->d_done);
+
+  for(int i = 0; i < 2; i++){
+    dev_buf_release(plan->d_inData[i]);
+    if(!plan->inplace)
+      dev_buf_release(plan->d_outData[i]);
+  }
+
+  if(plan->fetch_kernel) 
+    clReleaseKernel(plan->fetch_kernel);  
+  if(plan->transpose_kernel) 
+    clReleaseKernel(plan->transpose_kernel);  
+  if(plan->store_kernel) 
+    clReleaseKernel(plan->store_kernel);  
+
+  for(int b = 0; b < plan->banks; b++){
+    dev_buf_release(plan->d_bankIn[b]);
+    if(!plan->inplace)
+      dev_buf_release(plan->d_bankOut[b]);
+    for(int k = 0; k < 3; k++){
+      if(plan->bank_kernels[b][k])
+        clReleaseKernel(plan->bank_kernels[b][k]);
+    }
+  }
+
+  free(plan);
+}
+
+/**
+ * \brief  device side profile of the commands of an execution from their
+ *         events, relative to the first command queued
+ * \param  prof : valid unless profiling is unavailable, e.g. on emulators
+ * \param  write_ev, read_ev : NULL if the kernels access host memory
+ */
+static void profile_events(fpga_profile_t *prof, cl_event write_ev, cl_event fetch_ev, cl_event transpose_ev, cl_event store_ev, cl_event read_ev){
+  const cl_profiling_info info[4] = {
+    CL_PROFILING_COMMAND_QUEUED, CL_PROFILING_COMMAND_SUBMIT,
+    CL_PROFILING_COMMAND_START, CL_PROFILING_COMMAND_END
+  };
+  cl_event ev[5] = {write_ev, fetch_ev, transpose_ev, store_ev, read_ev};
+  fpga_event_times_t *times[5] = {&prof->write, &prof->fetch, &prof->transpose, &prof->store, &prof->read};
+  cl_ulong ns[5][4];
+  cl_ulong base = ~(cl_ulong)0;
+
+  memset(prof, 0, sizeof(fpga_profile_t));
+
+  for(int e = 0; e < 5; e++){
+    if(ev[e] == NULL)
+      continue;
+    for(int i = 0; i < 4; i++){
+      if(clGetEventProfilingInfo(ev[e], info[i], sizeof(cl_ulong), &ns[e][i], NULL) != CL_SUCCESS)
+        return;
+    }
+    base = (ns[e][0] < base) ? ns[e][0] : base;
+  }
+
+  for(int e = 0; e < 5; e++){
+    if(ev[e] == NULL)
+      continue;
+    times[e]->queued = (ns[e][0] - base) * 1e-6;
+    times[e]->submit = (ns[e][1] - base) * 1e-6;
+    times[e]->start = (ns[e][2] - base) * 1e-6;
+    times[e]->end = (ns[e][3] - base) * 1e-6;
+  }
+
+  // kernels of the pipeline run concurrently, connected by channels
+  double submit = prof->fetch.submit, start = prof->fetch.start, end = prof->fetch.end;
+  for(int e = 2; e < 4; e++){
+    submit = (times[e]->submit < submit) ? times[e]->submit : submit;
+    start = (times[e]->start < start) ? times[e]->start : start;
+    end = (times[e]->end > end) ? times[e]->end : end;
+  }
+  prof->launch_t = start - submit;
+  prof->pipeline_t = end - start;
+  prof->valid = 1;
+}
+
+/**
+ * \brief  device side profile of the last execution of a plan, blocking or
+ *         on shared virtual memory
+ * \retval 0 if the profile is valid
+ */
+int mTranspose_profile(const fpga_plan_t *plan, fpga_profile_t *prof){
+  if(plan == NULL || prof == NULL || !plan->profile.valid)
+    return 1;
+
+  *prof = plan->profile;
+  return 0;
+}
+
+/**
+ * \brief  device side profile of a completed request
+ * \retval 0 if the profile is valid
+ */
+int mTranspose_request_profile(fpga_request_t *req, fpga_profile_t *prof){
+  if(req == NULL || prof == NULL || !mTranspose_poll(req) || !req->profile.valid)
+    return 1;
+
+  *prof = req->profile;
+  return 0;
+}
+
+/**
+ * \brief  free a request and its events
+ */
+static void request_free(fpga_request_t *req){
+  clReleaseEvent(req->write_ev);
+  clReleaseEvent(req->fetch_ev);
+  clReleaseEvent(req->transpose_ev);
+  clReleaseEvent(req->store_ev);
+  clReleaseEvent(req->read_ev);
+  pthread_mutex_destroy(&req->lock);
+  pthread_cond_destroy(&req->done_cv);
+  free(req);
+}
+
+/**
+ * \brief  completion of the read of a request, times it from the profiling
+ *         of its events and calls its callback before waking waiters
+ */
+static void CL_CALLBACK request_complete(cl_event ev, cl_int status, void *data){
+  fpga_request_t *req = (fpga_request_t *)data;
+  fpga_t timing = {0.0, 0.0, 0.0, 0};
+  fpga_profile_t profile;
+  memset(&profile, 0, sizeof(fpga_profile_t));
+
+  if(status == CL_COMPLETE){
+    profile_events(&profile, req->write_ev, req->fetch_ev, req->transpose_ev, req->store_ev, req->read_ev);
+    timing.pcie_write_t = profile.write.end - profile.write.start;
+    timing.exec_t = profile.pipeline_t;
+    timing.pcie_read_t = profile.read.end - profile.read.start;
+    timing.valid = 1;
+  }
+  else{
+    fprintf(stderr, "Transpose request failed with status %d\n", status);
+  }
+
+  if(req->callback)
+    req->callback(req, timing, req->user_data);
+
+  pthread_mutex_lock(&req->lock);
+  req->timing = timing;
+  req->profile = profile;
+  req->done = 1;
+  int detached = req->detached;
+  pthread_cond_broadcast(&req->done_cv);
+  pthread_mutex_unlock(&req->lock);
+
+  if(detached)
+    request_free(req);
+}
+
+/**
+ * \brief  submit a transposition without waiting for it. Requests on a plan
+ *         alternate between two pairs of device buffers, so a request is
+ *         transferred while the previous one is transposed, and any number
+ *         can be in flight. They complete in order of submission.
+ * \param  plan      : plan created using mTranspose_plan()
+ * \param  inp       : pointer to input matrices, unchanged until completion
+ * \param  out       : pointer to output matrices, written until completion
+ * \param  batch     : number of matrices, at most the plan's batch
+ * \param  callback  : called on completion before waiters wake up, NULL if
+ *                     none. It may release the request but not wait on it.
+ * \param  user_data : passed to the callback
+ * \retval request to poll, wait on and release, NULL if invalid
+ */
+fpga_request_t* mTranspose_submit(fpga_plan_t *plan, float2 *inp, float2 *out, int batch, fpga_callback_t callback, void *user_data){
+  cl_int status = 0;
+
+  if(plan == NULL || inp == NULL || out == NULL || batch <= 0 || batch > plan->batch){
+    return NULL;
+  }
+
+  if(plan->banks > 0){
+    fprintf(stderr, "Asynchronous transpositions are not supported by banked bitstreams\n");
+    return NULL;
+  }
+
+  if(plan->persistent){
+    fprintf(stderr, "Asynchronous transpositions are not supported by persistent bitstreams\n");
+    return NULL;
+  }
+
+  pthread_mutex_lock(&plan->dev->submit_lock);
+  int failed = alloc_second_pair(plan);
+  pthread_mutex_unlock(&plan->dev->submit_lock);
+
+  fpga_request_t *req = failed ? NULL : (fpga_request_t *)calloc(1, sizeof(fpga_request_t));
+  if(req == NULL){
+    return NULL;
+  }
+  req->callback = callback;
+  req->user_data = user_data;
+  pthread_mutex_init(&req->lock, NULL);
+  pthread_cond_init(&req->done_cv, NULL);
+
+  fpga_device_t *dev = plan->dev;
+  const size_t sz = plan->elem_sz * batch * plan->N * plan->N;
+
+  pthread_mutex_lock(&dev->submit_lock);
+
+  const int b = plan->async_next;
+  plan->async_next ^= 1;
+
+  // input buffer can be overwritten once the fetch of the request before last is done
+  status = clEnqueueWriteBuffer(dev->queue4, plan->d_inData[b], CL_FALSE, 0, sz, inp, plan->async_fetch[b] ? 1 : 0, plan->async_fetch[b] ? &plan->async_fetch[b] : NULL, &req->write_ev);
+  checkError(status, "Failed to copy data to device");
+
+  // output buffer can be overwritten once its previous read is done
+  launch_kernels(plan, batch, plan->d_inData[b], plan->d_outData[b], &req->write_ev, plan->async_read[b] ? &plan->async_read[b] : NULL, &req->fetch_ev, &req->transpose_ev, &req->store_ev);
+
+  status = clEnqueueReadBuffer(dev->queue5, plan->d_outData[b], CL_FALSE, 0, sz, out, 1, &req->store_ev, &req->read_ev);
+  checkError(status, "Failed to read data from device");
+
+  if(plan->async_fetch[b])
+    clReleaseEvent(plan->async_fetch[b]);
+  if(plan->async_read[b])
+    clReleaseEvent(plan->async_read[b]);
+  clRetainEvent(req->fetch_ev);
+  clRetainEvent(req->read_ev);
+  plan->async_fetch[b] = req->fetch_ev;
+  plan->async_read[b] = req->read_ev;
+
+  status = clSetEventCallback(req->read_ev, CL_COMPLETE, request_complete, req);
+  checkError(status, "Failed to set completion callback");
+
+  clFlush(dev->queue4);
+  clFlush(dev->queue1);
+  clFlush(dev->queue2);
+  clFlush(dev->queue3);
+  clFlush(dev->queue5);
+
+  pthread_mutex_unlock(&dev->submit_lock);
+
+  return req;
+}
+
+/**
+ * \brief  1 if the request completed and its callback returned, 0 otherwise
+ */
+int mTranspose_poll(fpga_request_t *req){
+  if(req == NULL)
+    return 1;
+
+  pthread_mutex_lock(&req->lock);
+  int done = req->done;
+  pthread_mutex_unlock(&req->lock);
+  return done;
+}
+
+/**
+ * \brief  wait for a request to complete
+ * \retval fpga_t : PCIe transfers and execution in milliseconds of the
+ *                  request, from the profiling of its events
+ */
+fpga_t mTranspose_wait(fpga_request_t *req){
+  fpga_t mTranspose_time = {0.0, 0.0, 0.0, 0};
+
+  if(req == NULL)
+    return mTranspose_time;
+
+  pthread_mutex_lock(&req->lock);
+  while(!req->done)
+    pthread_cond_wait(&req->done_cv, &req->lock);
+  mTranspose_time = req->timing;
+  pthread_mutex_unlock(&req->lock);
+
+  return mTranspose_time;
+}
+
+/**
+ * \brief  release a request. If still in flight, it is freed on completion
+ *         and must not be used anymore.
+ */
+void mTranspose_release(fpga_request_t *req){
+  if(req == NULL)
+    return;
+
+  pthread_mutex_lock(&req->lock);
+  int done = req->done;
+  req->detached = !done;
+  pthread_mutex_unlock(&req->lock);
+
+  if(done)
+    request_free(req);
+}
+
+/**
+ * \brief  wait for the requests in flight on a plan before its buffers are
+ *         used otherwise
+ */
+static void async_drain(fpga_plan_t *plan){
+  fpga_device_t *dev = plan->dev;
+
+  pthread_mutex_lock(&dev->submit_lock);
+  for(int b = 0; b < 2; b++){
+    if(plan->async_read[b]){
+      clWaitForEvents(1, &plan->async_read[b]);
+      clReleaseEvent(plan->async_read[b]);
+      plan->async_read[b] = NULL;
+    }
+    if(plan->async_fetch[b]){
+      clReleaseEvent(plan->async_fetch[b]);
+      plan->async_fetch[b] = NULL;
+    }
+  }
+  pthread_mutex_unlock(&dev->submit_lock);
+}
+
+/*
+ * Aggregator of concurrent transpositions of the same N by many callers.
+ * Callers queue their matrices and block, a dispatcher thread launches the
+ * queued requests together as one batch of its plan once the batch is full
+ * or the oldest request waited for the latency budget. Every request is
+ * written to and read from its own offset of the device buffers, so neither
+ * gathered nor scattered on the host, except on banked plans staging the
+ * batch in host memory.
+ */
+typedef struct coalesce_entry {
+  float2 *inp, *out;
+  int batch;
+  double submit_t;
+  int done;
+  fpga_t timing;
+  struct coalesce_entry *next;
+} coalesce_entry_t;
+
+struct fpga_coalescer {
+  fpga_plan_t *plan;
+  double budget_t;
+  pthread_t dispatcher;
+  pthread_mutex_t lock;
+  pthread_cond_t pending_cv;  // request queued or stopped
+  pthread_cond_t done_cv;     // launch completed
+  coalesce_entry_t *head, *tail;
+  int pending;  // matrices queued
+  int stop;
+  float2 *staging_in, *staging_out;  // banked plans only
+  fpga_coalesce_stats_t stats;
+  size_t launched;     // requests taken from the queue
+  double queue_sum_t;  // total queueing delay of those
+};
+
+/**
+ * \brief  transpose the num requests from first together in one execution
+ *         of the plan
+ * \retval fpga_t : timing of the launch of batch matrices
+ */
+static fpga_t coalesce_launch(fpga_coalescer_t *co, coalesce_entry_t *first, int num, int batch){
+  fpga_t mTranspose_time = {0.0, 0.0, 0.0, 0};
+  fpga_plan_t *plan = co->plan;
+  fpga_device_t *dev = plan->dev;
+  const size_t mat_sz = plan->elem_sz * plan->N * plan->N;
+  cl_int status = 0;
+  coalesce_entry_t *e;
+  int i;
+  size_t off;
+
+  if(plan->banks > 0){
+    for(e = first, i = 0, off = 0; i < num; e = e->next, i++){
+      memcpy((char *)co->staging_in + off, e->inp, e->batch * mat_sz);
+      off += e->batch * mat_sz;
+    }
+    mTranspose_time = bank_execute(plan, co->staging_in, co->staging_out, batch);
+    for(e = first, i = 0, off = 0; i < num; e = e->next, i++){
+      memcpy(e->out, (char *)co->staging_out + off, e->batch * mat_sz);
+      off += e->batch * mat_sz;
+    }
+    return mTranspose_time;
+  }
+
+  cl_event fetch_ev, transpose_ev, store_ev;
+
+  mTranspose_time.pcie_write_t = getTimeinMilliSec();
+  for(e = first, i = 0, off = 0; i < num; e = e->next, i++){
+    status = clEnqueueWriteBuffer(dev->queue1, plan->d_inData[0], CL_FALSE, off, e->batch * mat_sz, e->inp, 0, NULL, NULL);
+    checkError(status, "Failed to copy data to device");
+    off += e->batch * mat_sz;
+  }
+  status = clFinish(dev->queue1);
+  checkError(status, "failed to finish");
+  mTranspose_time.pcie_write_t = getTimeinMilliSec() - mTranspose_time.pcie_write_t;
+
+  double start = getTimeinMilliSec();
+  if(plan->persistent){
+    // the requests in place, posted as a single descriptor
+    if(persist_post(plan, 0, batch))
+      return mTranspose_time;
+  }
+  else{
+    launch_kernels(plan, batch, plan->d_inData[0], plan->d_outData[0], NULL, NULL, &fetch_ev, &transpose_ev, &store_ev);
+
+    status = clFinish(dev->queue1);
+    checkError(status, "failed to finish");
+    status = clFinish(dev->queue2);
+    checkError(status, "failed to finish");
+    status = clFinish(dev->queue3);
+    checkError(status, "failed to finish");
+  }
+  mTranspose_time.exec_t = getTimeinMilliSec() - start;
+
+  mTranspose_time.pcie_read_t = getTimeinMilliSec();
+  for(e = first, i = 0, off = 0; i < num; e = e->next, i++){
+    status = clEnqueueReadBuffer(dev->queue1, plan->d_outData[0], CL_FALSE, off, e->batch * mat_sz, e->out, 0, NULL, NULL);
+    checkError(status, "Failed to read data from device");
+    off += e->batch * mat_sz;
+  }
+  status = clFinish(dev->queue1);
+  checkError(status, "failed to finish");
+  mTranspose_time.pcie_read_t = getTimeinMilliSec() - mTranspose_time.pcie_read_t;
+
+  if(plan->persistent){
+    mTranspose_time.valid = 1;
+    return mTranspose_time;
+  }
+
+  // transfers of every request are timed together on the host
+  profile_events(&plan->profile, NULL, fetch_ev, transpose_ev, store_ev, NULL);
+  if(plan->profile.valid)
+    mTranspose_time.exec_t = plan->profile.pipeline_t;
+
+  clReleaseEvent(fetch_ev);
+  clReleaseEvent(transpose_ev);
+  clReleaseEvent(store_ev);
+
+  mTranspose_time.valid = 1;
+  return mTranspose_time;
+}
+
+/**
+ * \brief  absolute deadline of the budget of a request for timed waits
+ */
+static struct timespec coalesce_deadline(double submit_t, double budget_t){
+  struct timespec ts;
+  double left = submit_t + budget_t - getTimeinMilliSec();
+
+  clock_gettime(CLOCK_REALTIME, &ts);
+  if(left > 0.0){
+    long ns = ts.tv_nsec + (long)(left * 1e6);
+    ts.tv_sec += ns / 1000000000L;
+    ts.tv_nsec = ns % 1000000000L;
+  }
+  return ts;
+}
+
+/**
+ * \brief  dispatcher of a coalescer, launches the queued requests in order
+ *         until stopped and the queue is empty
+ */
+static void* coalesce_dispatch(void *arg){
+  fpga_coalescer_t *co = (fpga_coalescer_t *)arg;
+  const int max_batch = co->plan->batch;
+
+  pthread_mutex_lock(&co->lock);
+  while(1){
+    while(!co->stop && co->head == NULL)
+      pthread_cond_wait(&co->pending_cv, &co->lock);
+    if(co->head == NULL)
+      break;
+
+    // wait for a full batch until the oldest request's budget expires
+    while(!co->stop && co->pending < max_batch && getTimeinMilliSec() < co->head->submit_t + co->budget_t){
+      struct timespec ts = coalesce_deadline(co->head->submit_t, co->budget_t);
+      pthread_cond_timedwait(&co->pending_cv, &co->lock, &ts);
+    }
+
+    // requests in order while they fit the batch of the plan
+    coalesce_entry_t *first = co->head, *last = NULL;
+    int num = 0, batch = 0;
+    for(coalesce_entry_t *e = co->head; e != NULL && batch + e->batch <= max_batch; e = e->next){
+      batch += e->batch;
+      last = e;
+      num++;
+    }
+    co->head = last->next;
+    if(co->head == NULL)
+      co->tail = NULL;
+    co->pending -= batch;
+
+    co->launched += num;
+    double launch_t = getTimeinMilliSec();
+    for(coalesce_entry_t *e = first; e != co->head; e = e->next){
+      double queue_t = launch_t - e->submit_t;
+      co->queue_sum_t += queue_t;
+      if(queue_t > co->stats.max_queue_t)
+        co->stats.max_queue_t = queue_t;
+    }
+    pthread_mutex_unlock(&co->lock);
+
+    fpga_t timing = coalesce_launch(co, first, num, batch);
+
+    pthread_mutex_lock(&co->lock);
+    co->stats.launches++;
+    co->stats.matrices += batch;
+    co->stats.full += (batch == max_batch);
+    if(batch > co->stats.max_batch)
+      co->stats.max_batch = batch;
+
+    // entries are on the stacks of their callers, gone once done
+    for(coalesce_entry_t *e = first, *next; e != NULL; e = next){
+      next = (e == last) ? NULL : e->next;
+      e->timing = timing;
+      e->done = 1;
+    }
+    pthread_cond_broadcast(&co->done_cv);
+  }
+  pthread_mutex_unlock(&co->lock);
+  return NULL;
+}
+
+/**
+ * \brief  create a coalescer of concurrent transpositions of N x N single
+ *         precision complex matrices on the first FPGA
+ * \param  N         : length of the matrix
+ * \param  max_batch : matrices of a launch, the batch of its plan
+ * \param  budget_ms : longest a request waits for others before its launch
+ * \param  isND      : 1 if kernel is ND Range
+ * \retval coalescer, NULL on failure, destroyed before fpga_final()
+ */
+fpga_coalescer_t* mTranspose_coalescer(int N, int max_batch, double budget_ms, int isND){
+  if(max_batch <= 0 || budget_ms < 0.0){
+    return NULL;
+  }
+
+  fpga_coalescer_t *co = (fpga_coalescer_t *)calloc(1, sizeof(fpga_coalescer_t));
+  if(co == NULL){
+    return NULL;
+  }
+
+  co->plan = mTranspose_plan(N, max_batch, isND);
+  if(co->plan == NULL){
+    free(co);
+    return NULL;
+  }
+  co->budget_t = budget_ms;
+
+  if(co->plan->banks > 0){
+    co->staging_in = (float2 *)fpgaf_complex_malloc(co->plan->buf_sz, 0);
+    co->staging_out = (float2 *)fpgaf_complex_malloc(co->plan->buf_sz, 0);
+  }
+
+  pthread_mutex_init(&co->lock, NULL);
+  pthread_cond_init(&co->pending_cv, NULL);
+  pthread_cond_init(&co->done_cv, NULL);
+
+  if((co->plan->banks > 0 && (co->staging_in == NULL || co->staging_out == NULL)) ||
+     pthread_create(&co->dispatcher, NULL, coalesce_dispatch, co) != 0){
+    pthread_mutex_destroy(&co->lock);
+    pthread_cond_destroy(&co->pending_cv);
+    pthread_cond_destroy(&co->done_cv);
+    fpga_complex_free(co->staging_in);
+    fpga_complex_free(co->staging_out);
+    mTranspose_destroy(co->plan);
+    free(co);
+    return NULL;
+  }
+
+  return co;
+}
+
+/**
+ * \brief  transpose matrices of a caller together with those of concurrent
+ *         callers, blocks until transposed. Thread safe.
+ * \param  co    : coalescer created using mTranspose_coalescer()
+ * \param  inp   : pointer to input matrices
+ * \param  out   : pointer to output matrices
+ * \param  batch : number of matrices, at most the batch of the coalescer
+ * \retval fpga_t : timing of the launch the matrices were part of
+ */
+fpga_t mTranspose_coalesce(fpga_coalescer_t *co, float2 *inp, float2 *out, int batch){
+  fpga_t mTranspose_time = {0.0, 0.0, 0.0, 0};
+
+  if(co == NULL || inp == NULL || out == NULL || batch <= 0 || batch > co->plan->batch){
+    return mTranspose_time;
+  }
+
+  coalesce_entry_t entry = {inp, out, batch, getTimeinMilliSec(), 0, {0.0, 0.0, 0.0, 0}, NULL};
+
+  pthread_mutex_lock(&co->lock);
+  if(co->stop){
+    pthread_mutex_unlock(&co->lock);
+    return mTranspose_time;
+  }
+
+  if(co->tail != NULL)
+    co->tail->next = &entry;
+  else
+    co->head = &entry;
+  co->tail = &entry;
+  co->pending += batch;
+  co->stats.requests++;
+  pthread_cond_signal(&co->pending_cv);
+
+  while(!entry.done)
+    pthread_cond_wait(&co->done_cv, &co->lock);
+  pthread_mutex_unlock(&co->lock);
+
+  return entry.timing;
+}
+
+/**
+ * \brief  batching achieved by a coalescer and the delay added by queueing
+ */
+void mTranspose_coalesce_stats(fpga_coalescer_t *co, fpga_coalesce_stats_t *stats){
+  if(co == NULL || stats == NULL)
+    return;
+
+  pthread_mutex_lock(&co->lock);
+  *stats = co->stats;
+  stats->avg_batch = co->stats.launches ? (double)co->stats.matrices / co->stats.launches : 0.0;
+  stats->avg_queue_t = co->launched ? co->queue_sum_t / co->launched : 0.0;
+  pthread_mutex_unlock(&co->lock);
+}
+
+/**
+ * \brief  launch the requests still queued, then release the coalescer
+ *         once none of its callers is blocked
+ */
+void mTranspose_coalescer_destroy(fpga_coalescer_t *co){
+  if(co == NULL)
+    return;
+
+  pthread_mutex_lock(&co->lock);
+  co->stop = 1;
+  pthread_cond_signal(&co->pending_cv);
+  pthread_mutex_unlock(&co->lock);
+  pthread_join(co->dispatcher, NULL);
+
+  pthread_mutex_destroy(&co->lock);
+  pthread_cond_destroy(&co->pending_cv);
+  pthread_cond_destroy(&co->done_cv);
+  fpga_complex_free(co->staging_in);
+  fpga_complex_free(co->staging_out);
+  mTranspose_destroy(co->plan);
+  free(co);
+}
+
+/**
+ * \brief  compute an complex single precision matrix transposition on the FPGA
+ * \param  N   : length of the matrix
+ * \param  inp : pointer to input matrix
+ * \param  out : pointer to output matrix
+ * \param  batch : number of transposes to perform in a batched mode
+ * \param  use_svm : 1 if pcie transfers are SVM based
+ * \param  isND : 1 if kernel is ND Range
+ * \retval fpga_t : time taken in milliseconds for data transfers and execution
+ */
+fpga_t mTranspose(int N, float2 *inp, float2 *out, int batch, int use_svm, int isND){
+  fpga_t mTranspose_time = {0.0, 0.0, 0.0, 0};
+
+  if(inp == NULL || out == NULL){
+    return mTranspose_time;
+  }
+
+  fpga_plan_t *plan = mTranspose_plan(N, batch, isND);
+  if(plan == NULL){
+    return mTranspose_time;
+  }
+
+  mTranspose_time = mTranspose_execute(plan, inp, out, batch);
+
+  mTranspose_destroy(plan);
+
+  return mTranspose_time;
+}
+
+/**
+ * \brief  transpose as mTranspose() in place, a single device buffer of
+ *         batch matrices
+ * \param  data : pointer to the matrices, overwritten by their transpose
+ */
+fpga_t mTranspose_inplace(int N, float2 *data, int batch, int isND){
+  fpga_t mTranspose_time = {0.0, 0.0, 0.0, 0};
+
+  if(data == NULL){
+    return mTranspose_time;
+  }
+
+  fpga_plan_t *plan = mTranspose_plan_inplace(N, batch, isND);
+  if(plan == NULL){
+    return mTranspose_time;
+  }
+
+  mTranspose_time = mTranspose_execute_inplace(plan, data, batch);
+
+  mTranspose_destroy(plan);
+
+  return mTranspose_time;
+}
+
+// Slice of a batch transposed by a device of mTranspose_multi()
+typedef struct {
+  fpga_device_t *dev;
+  int N, batch, isND;
+  float2 *inp, *out;
+  fpga_t timing;
+} multi_job_t;
+
+static void* multi_worker(void *arg){
+  multi_job_t *job = (multi_job_t *)arg;
+
+  fpga_plan_t *plan = plan_create(job->dev, job->N, job->batch, job->isND, sizeof(float2), 0);
+  if(plan != NULL){
+    job->timing = plan_execute(plan, job->inp, job->out, job->batch);
+    mTranspose_destroy(plan);
+  }
+  return NULL;
+}
+
+/**
+ * \brief  transpose a batch of single precision complex matrices spread
+ *         across every FPGA of the platform, each device transposing a
+ *         contiguous slice concurrently. Slices are proportional to the
+ *         throughput of the devices measured by previous calls, equal until
+ *         every device has been measured.
+ * \param  N     : length of the matrix
+ * \param  inp   : pointer to input matrices
+ * \param  out   : pointer to output matrices
+ * \param  batch : number of matrices to transpose
+ * \param  isND  : 1 if kernel is ND Range
+ * \param  multi : slices and timings of every device if not NULL
+ * \retval fpga_t : slowest device of every phase in milliseconds
+ */
+fpga_t mTranspose_multi(int N, float2 *inp, float2 *out, int batch, int isND, fpga_multi_t *multi){
+  fpga_t mTranspose_time = {0.0, 0.0, 0.0, 0};
+  multi_job_t job[FPGA_MAX_DEVICES];
+  pthread_t thread[FPGA_MAX_DEVICES];
+  int started[FPGA_MAX_DEVICES];
+
+  if(inp == NULL || out == NULL || batch <= 0 || num_fpga_dev == 0){
+    return mTranspose_time;
+  }
+
+  const int devs = (num_fpga_dev < FPGA_MAX_DEVICES) ? num_fpga_dev : FPGA_MAX_DEVICES;
+  const size_t mat_sz = (size_t)N * N;
+
+  double total = 0.0;
+  int measured = 1;
+  for(int d = 0; d < devs; d++){
+    total += fpga_dev[d].rate;
+    measured = measured && (fpga_dev[d].rate > 0.0);
+  }
+
+  // slices start at the rounded share of the devices before
+  double share = 0.0;
+  int start = 0;
+  for(int d = 0; d < devs; d++){
+    share += measured ? (fpga_dev[d].rate / total) : (1.0 / devs);
+    int end = (d == devs - 1) ? batch : (int)(share * batch + 0.5);
+
+    memset(&job[d], 0, sizeof(multi_job_t));
+    job[d].dev = &fpga_dev[d];
+    job[d].N = N;
+    job[d].batch = end - start;
+    job[d].isND = isND;
+    job[d].inp = inp + (start * mat_sz);
+    job[d].out = out + (start * mat_sz);
+    start = end;
+  }
+
+  // a thread per device, the caller's if a thread cannot be started
+  double wall = getTimeinMilliSec();
+  for(int d = 0; d < devs; d++){
+    started[d] = 0;
+    if(job[d].batch > 0){
+      if(pthread_create(&thread[d], NULL, multi_worker, &job[d]) == 0)
+        started[d] = 1;
+      else
+        multi_worker(&job[d]);
+    }
+  }
+  for(int d = 0; d < devs; d++){
+    if(started[d])
+      pthread_join(thread[d], NULL);
+  }
+  wall = getTimeinMilliSec() - wall;
+
+  mTranspose_time.valid = 1;
+  for(int d = 0; d < devs; d++){
+    fpga_t *t = &job[d].timing;
+    if(job[d].batch == 0)
+      continue;
+    if(t->valid != 1){
+      mTranspose_time.valid = 0;
+      continue;
+    }
+
+    // matrices per ms including transfers, averaged with previous calls
+    double rate = job[d].batch / (t->pcie_write_t + t->exec_t + t->pcie_read_t);
+    fpga_dev[d].rate = (fpga_dev[d].rate > 0.0) ? 0.5 * (fpga_dev[d].rate + rate) : rate;
+
+    if(t->pcie_write_t > mTranspose_time.pcie_write_t)
+      mTranspose_time.pcie_write_t = t->pcie_write_t;
+    if(t->exec_t > mTranspose_time.exec_t)
+      mTranspose_time.exec_t = t->exec_t;
+    if(t->pcie_read_t > mTranspose_time.pcie_read_t)
+      mTranspose_time.pcie_read_t = t->pcie_read_t;
+  }
+
+  if(multi != NULL){
+    multi->devices = devs;
+    multi->total_t = wall;
+    for(int d = 0; d < devs; d++){
+      multi->batch[d] = job[d].batch;
+      multi->timing[d] = job[d].timing;
+    }
+  }
+
+  return mTranspose_time;
+}
+
+/**
+ * \brief  compute a double precision complex matrix transposition on the
+ *         FPGA, requires a bitstream built with TYPE double2
+ * \param  N   : length of the matrix
+ * \param  inp : pointer to input matrix
+ * \param  out : pointer to output matrix
+ * \param  batch : number of transposes to perform in a batched mode
+ * \param  use_svm : 1 if pcie transfers are SVM based
+ * \param  isND : 1 if kernel is ND Range
+ * \retval fpga_t : time taken in milliseconds for data transfers and execution
+ */
+fpga_t mTranspose_d(int N, double2 *inp, double2 *out, int batch, int use_svm, int isND){
+  fpga_t mTranspose_time = {0.0, 0.0, 0.0, 0};
+
+  if(inp == NULL || out == NULL){
+    return mTranspose_time;
+  }
+
+  fpga_plan_t *plan = mTranspose_plan_d(N, batch, isND);
+  if(plan == NULL){
+    return mTranspose_time;
+  }
+
+  mTranspose_time = mTranspose_execute_d(plan, inp, out, batch);
+
+  mTranspose_destroy(plan);
+
+  return mTranspose_time;
+}
+
+/**
+ * \brief Create a command queue for each kernel of a device
+ */
+static void queue_setup(fpga_device_t *dev){
+  cl_int status = 0;
+  // Create one command queue for each kernel.
+  dev->queue1 = clCreateCommandQueue(context, dev->id, CL_QUEUE_PROFILING_ENABLE, &status);
+  checkError(status, "Failed to create command queue1");
+  dev->queue2 = clCreateCommandQueue(context, dev->id, CL_QUEUE_PROFILING_ENABLE, &status);
+  checkError(status, "Failed to create command queue2");
+  dev->queue3 = clCreateCommandQueue(context, dev->id, CL_QUEUE_PROFILING_ENABLE, &status);
+  checkError(status, "Failed to create command queue3");
+
+  // Transfers to and from the device
+  dev->queue4 = clCreateCommandQueue(context, dev->id, CL_QUEUE_PROFILING_ENABLE, &status);
+  checkError(status, "Failed to create command queue4");
+  dev->queue5 = clCreateCommandQueue(context, dev->id, CL_QUEUE_PROFILING_ENABLE, &status);
+  checkError(status, "Failed to create command queue5");
+
+  // Pipelines of a banked bitstream beyond the first
+  dev->bank_queue[0][0] = dev->queue1;
+  dev->bank_queue[0][1] = dev->queue2;
+  dev->bank_queue[0][2] = dev->queue3;
+  for(int b = 1; b < dev->banks; b++){
+    for(int k = 0; k < 3; k++){
+      dev->bank_queue[b][k] = clCreateCommandQueue(context, dev->id, CL_QUEUE_PROFILING_ENABLE, &status);
+      checkError(status, "Failed to create bank command queue");
+    }
+  }
+}
+
+/**
+ * \brief Release all command queues of every device
+ */
+void queue_cleanup() {
+  for(int d = 0; d < num_fpga_dev; d++){
+    fpga_device_t *dev = &fpga_dev[d];
+
+    if(dev->queue1) 
+      clReleaseCommandQueue(dev->queue1);
+    if(dev->queue2) 
+      clReleaseCommandQueue(dev->queue2);
+    if(dev->queue3) 
+      clReleaseCommandQueue(dev->queue3);
+    if(dev->queue4) 
+      clReleaseCommandQueue(dev->queue4);
+    if(dev->queue5) 
+      clReleaseCommandQueue(dev->queue5);
+    dev->queue1 = dev->queue2 = dev->queue3 = dev->queue4 = dev->queue5 = NULL;
+
+    for(int b = 1; b < MAX_PIPELINES; b++){
+      for(int k = 0; k < 3; k++){
+        if(dev->bank_queue[b][k])
+          clReleaseCommandQueue(dev->bank_queue[b][k]);
+      }
+    }
+    memset(dev->bank_queue, 0, sizeof(dev->bank_queue));
+  }
+}
+
+/*
+ * FPGA backend: a plan is kept until a larger batch or another size is
+ * requested
+ */
+static fpga_plan_t *backend_plan = NULL;
+static int backend_svm = 0, backend_isND = 0, backend_inplace = 0;
+
+static int fpga_backend_init(const mtrans_opts_t *opts){
+  backend_svm = opts->use_svm;
+  backend_isND = opts->isND;
+  backend_inplace = opts->inplace;
+  return fpga_initialize(opts->platform, opts->path, opts->use_svm, opts->use_emulator);
+}
+
+static void* fpga_backend_alloc(size_t sz){
+  return fpgaf_complex_malloc(sz, backend_svm);
+}
+
+static fpga_t fpga_backend_transpose(int N, float2 *inp, float2 *out, int batch){
+  if(backend_plan == NULL || backend_plan->N != N || backend_plan->batch < batch){
+    mTranspose_destroy(backend_plan);
+    backend_plan = backend_inplace ? mTranspose_plan_inplace(N, batch, backend_isND) : mTranspose_plan(N, batch, backend_isND);
+  }
+  return mTranspose_execute(backend_plan, inp, out, batch);
+}
+
+static void fpga_backend_finalize(){
+  mTranspose_destroy(backend_plan);
+  backend_plan = NULL;
+  fpga_final();
+}
+
+const mtrans_backend_t fpga_backend = {
+  "fpga",
+  fpga_backend_init,
+  fpga_backend_alloc,
+  fpga_complex_free,
+  fpga_backend_transpose,
+  fpga_backend_finalize
+};
@@ -7,37 +7,27 @@
 */
 
 #include "mtrans_config.h"
+#include "size.cl"
 
-// Log of the number of replications of the pipeline
-#define LOGREPL 2            // 4 replications 
-#define REPL (1 << LOGREPL)  // 4 replications 
-#define UNROLL_FACTOR 8 
+#define UNROLL_FACTOR POINTS
 
 #pragma OPENCL EXTENSION cl_intel_channels : enable
-channel float2 chaninTranspose[8] __attribute__((depth(8)));
-channel float2 chanoutTranspose[8] __attribute__((depth(8)));
+channel elem_t chaninTranspose[POINTS] __attribute__((depth(POINTS)));
+channel elem_t chanoutTranspose[POINTS] __attribute__((depth(POINTS)));
 
 __attribute__((max_global_work_dim(0)))
-kernel void fetch(global const volatile float2 * restrict src, int batch) {
-  const unsigned N = (1 << LOGN);
+kernel void fetch(global const volatile elem_t * restrict src, int batch) {
+  for(unsigned i = 0; i < (batch * N * (N / POINTS)); i++){
 
-  for(unsigned i = 0; i < (batch * N * (N / 8)); i++){
-
-    write_channel_intel(chaninTranspose[0], src[(i * 8) + 0]);
-    write_channel_intel(chaninTranspose[1], src[(i * 8) + 1]);
-    write_channel_intel(chaninTranspose[2], src[(i * 8) + 2]);
-    write_channel_intel(chaninTranspose[3], src[(i * 8) + 3]);
-    write_channel_intel(chaninTranspose[4], src[(i * 8) + 4]);
-    write_channel_intel(chaninTranspose[5], src[(i * 8) + 5]);
-    write_channel_intel(chaninTranspose[6], src[(i * 8) + 6]);
-    write_channel_intel(chaninTranspose[7], src[(i * 8) + 7]);
+    #pragma unroll POINTS
+    for(unsigned j = 0; j < POINTS; j++){
+      write_channel_intel(chaninTranspose[j], src[(i * POINTS) + j]);
+    }
   }
 }
 
 __attribute__((max_global_work_dim(0)))
 kernel void transpose(int batch) {
-  const unsigned N = (1 << LOGN);
-
   /* Input: Create M20ks banked column-wise, fill with rotated data
    *  - width : 512 bits or 8 complex or 8 banks, since input sample size
    *  - depth : N * N / 8, eg. 64 * 64 / 8 deep, to fill the M20k maximum
@@ -66,24 +56,20 @@ kernel void transpose(int batch) {
   // iterate over 2d matrices
   for(unsigned k = 0 ; k < batch; k++){
 
-    // Buffer with width - 8 points, depth - (N*N / 8), banked column-wise
-    float2 buf[DEPTH][POINTS];
+    // Buffer with width - POINTS, depth - (N*N / POINTS), banked column-wise
+    elem_t buf[DEPTH][POINTS];
       
     // iterate within a 2d matrix
     for(unsigned row = 0; row < DEPTH; row++){
 
       // Temporary buffer to rotate before filling the matrix
-      float2 rotate_in[POINTS];
+      elem_t rotate_in[POINTS];
 
       // store data in a temp buffer
-      rotate_in[0] = read_channel_intel(chaninTranspose[0]);
-      rotate_in[1] = read_channel_intel(chaninTranspose[1]);
-      rotate_in[2] = read_channel_intel(chaninTranspose[2]);
-      rotate_in[3] = read_channel_intel(chaninTranspose[3]);
-      rotate_in[4] = read_channel_intel(chaninTranspose[4]);
-      rotate_in[5] = read_channel_intel(chaninTranspose[5]);
-      rotate_in[6] = read_channel_intel(chaninTranspose[6]);
-      rotate_in[7] = read_channel_intel(chaninTranspose[7]);
+      #pragma unroll POINTS
+      for(unsigned i = 0; i < POINTS; i++){
+        rotate_in[i] = read_channel_intel(chaninTranspose[i]);
+      }
 
       /*  Computing whether and how much to rotate.
        *  Idea: Rotate every N / 8 rows, wrap around after 8 rotations
@@ -110,7 +96,7 @@ kernel void transpose(int batch) {
        *    output -  { 71, 64, 65 .. 70}
        *
        */
-      #pragma unroll 8
+      #pragma unroll POINTS
       for(unsigned i = 0; i < POINTS; i++){
           buf[row][i] = rotate_in[((i + POINTS) - rot) & (POINTS -1)];
       }
@@ -120,7 +106,7 @@ kernel void transpose(int batch) {
 
     for(unsigned row = 0; row < DEPTH; row++){
 
-      float2 rotate_out[POINTS];
+      elem_t rotate_out[POINTS];
 
     /* Idea: Fetch transposed data that is already rotated
      *
@@ -210,7 +196,7 @@ kernel void transpose(int batch) {
       unsigned offset = row >> LOGN;                    // 0, .. N / POINTS
 
       // store data into temp buffer
-      #pragma unroll 8
+      #pragma unroll POINTS
       for(unsigned i = 0; i < POINTS; i++){
         unsigned rot = ( (POINTS + i - (row >> (LOGN - LOGPOINTS))) << (LOGN - LOGPOINTS)) & (N - 1);
         unsigned row_rotate  = base + offset + rot;
@@ -227,14 +213,10 @@ kernel void transpose(int batch) {
       */
       unsigned rot_out = row >> (LOGN - LOGPOINTS) & (POINTS - 1);
 
-      write_channel_intel(chanoutTranspose[0], rotate_out[(0 + rot_out) & (POINTS - 1)]);
-      write_channel_intel(chanoutTranspose[1], rotate_out[(1 + rot_out) & (POINTS - 1)]);
-      write_channel_intel(chanoutTranspose[2], rotate_out[(2 + rot_out) & (POINTS - 1)]);
-      write_channel_intel(chanoutTranspose[3], rotate_out[(3 + rot_out) & (POINTS - 1)]);
-      write_channel_intel(chanoutTranspose[4], rotate_out[(4 + rot_out) & (POINTS - 1)]);
-      write_channel_intel(chanoutTranspose[5], rotate_out[(5 + rot_out) & (POINTS - 1)]);
-      write_channel_intel(chanoutTranspose[6], rotate_out[(6 + rot_out) & (POINTS - 1)]);
-      write_channel_intel(chanoutTranspose[7], rotate_out[(7 + rot_out) & (POINTS - 1)]);
+      #pragma unroll POINTS
+      for(unsigned i = 0; i < POINTS; i++){
+        write_channel_intel(chanoutTranspose[i], rotate_out[(i + rot_out) & (POINTS - 1)]);
+      }
 
     }
   }
@@ -242,18 +224,13 @@ kernel void transpose(int batch) {
 }
 
 __attribute__((max_global_work_dim(0)))
-kernel void store(global float2 * restrict dest, int batch) {
-  const int N = (1 << LOGN);
+kernel void store(global elem_t * restrict dest, int batch) {
+  for(unsigned i = 0; i < (batch * N * (N / POINTS)); i++){
 
-  for(unsigned i = 0; i < (batch * N * (N / 8)); i++){
-    dest[(i * 8) + 0] = read_channel_intel(chanoutTranspose[0]);
-    dest[(i * 8) + 1] = read_channel_intel(chanoutTranspose[1]);
-    dest[(i * 8) + 2] = read_channel_intel(chanoutTranspose[2]);
-    dest[(i * 8) + 3] = read_channel_intel(chanoutTranspose[3]);
-    dest[(i * 8) + 4] = read_channel_intel(chanoutTranspose[4]);
-    dest[(i * 8) + 5] = read_channel_intel(chanoutTranspose[5]);
-    dest[(i * 8) + 6] = read_channel_intel(chanoutTranspose[6]);
-    dest[(i * 8) + 7] = read_channel_intel(chanoutTranspose[7]);
+    #pragma unroll POINTS
+    for(unsigned j = 0; j < POINTS; j++){
+      dest[(i * POINTS) + j] = read_channel_intel(chanoutTranspose[j]);
+    }
   }
 
 }
\ No newline at end of file
@@ -1,22 +1,16 @@
 // Authors: Tobias Kenter, Arjun Ramaswami
 
-typedef struct {
-   float2 i0;
-   float2 i1;
-   float2 i2;
-   float2 i3;
-   float2 i4;
-   float2 i5;
-   float2 i6;
-   float2 i7;
-} float2x8;
-
-float2x8 readBuf(float2 bufA[DEPTH][POINTS], unsigned step){
+/*
+* Diagonal transposition of a matrix buffered as DEPTH words of POINTS
+* elements, for any POINTS that divides N.
+*/
+
+elemP_t readBuf(elem_t bufA[DEPTH][POINTS], unsigned step){
   // const unsigned N = (1 << LOGN);
   unsigned base = (step & (N / POINTS - 1)) << LOGN; // 0, N, 2N, ...
-  unsigned offset = (step >> LOGN) & ((N / 8) - 1);  // 0, .. N / POINTS
-  float2 rotate_out[POINTS];
-  float2x8 data;
+  unsigned offset = (step >> LOGN) & ((N / POINTS) - 1);  // 0, .. N / POINTS
+  elem_t rotate_out[POINTS];
+  elemP_t data;
 
   #pragma unroll POINTS
   for(unsigned i = 0; i < POINTS; i++){
@@ -26,19 +20,16 @@ float2x8 readBuf(float2 bufA[DEPTH][POINTS], unsigned step){
   }
 
   unsigned rot_out = (step >> (LOGN - LOGPOINTS)) & (POINTS - 1);
-  data.i0 = rotate_out[(0 + rot_out) & (POINTS - 1)];
-  data.i1 = rotate_out[(1 + rot_out) & (POINTS - 1)];
-  data.i2 = rotate_out[(2 + rot_out) & (POINTS - 1)];
-  data.i3 = rotate_out[(3 + rot_out) & (POINTS - 1)];
-  data.i4 = rotate_out[(4 + rot_out) & (POINTS - 1)];
-  data.i5 = rotate_out[(5 + rot_out) & (POINTS - 1)];
-  data.i6 = rotate_out[(6 + rot_out) & (POINTS - 1)];
-  data.i7 = rotate_out[(7 + rot_out) & (POINTS - 1)];
+
+  #pragma unroll POINTS
+  for(unsigned i = 0; i < POINTS; i++){
+    data.i[i] = rotate_out[(i + rot_out) & (POINTS - 1)];
+  }
 
   return data;
 }
 
-void writeBuf(float2 data[POINTS], float2 bufA[DEPTH][POINTS], unsigned step){
+void writeBuf(elem_t data[POINTS], elem_t bufA[DEPTH][POINTS], unsigned step){
   // const unsigned N = (1 << LOGN);
 
   unsigned row = step & (DEPTH - 1);
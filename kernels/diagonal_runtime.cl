@@ -0,0 +1,43 @@
+// Authors: Tobias Kenter, Arjun Ramaswami
+
+/*
+* Diagonal transposition as in diagonal_opt.cl of a matrix of length
+* n = 2^logn given at runtime, from POINTS up to N of the configuration. The
+* buffer is sized for N, a smaller matrix uses its first n * n / POINTS words.
+*/
+
+elemP_t readBuf(elem_t bufA[DEPTH][POINTS], unsigned step, unsigned logn){
+  const unsigned n = (1 << logn);
+  unsigned base = (step & (n / POINTS - 1)) << logn; // 0, n, 2n, ...
+  unsigned offset = (step >> logn) & ((n / POINTS) - 1);  // 0, .. n / POINTS
+  elem_t rotate_out[POINTS];
+  elemP_t data;
+
+  #pragma unroll POINTS
+  for(unsigned i = 0; i < POINTS; i++){
+    unsigned rot = ((POINTS + i - (step >> (logn - LOGPOINTS))) << (logn - LOGPOINTS)) & (n - 1);
+    unsigned row_rotate = base + offset + rot;
+    rotate_out[i] = bufA[row_rotate][i];
+  }
+
+  unsigned rot_out = (step >> (logn - LOGPOINTS)) & (POINTS - 1);
+
+  #pragma unroll POINTS
+  for(unsigned i = 0; i < POINTS; i++){
+    data.i[i] = rotate_out[(i + rot_out) & (POINTS - 1)];
+  }
+
+  return data;
+}
+
+void writeBuf(elem_t data[POINTS], elem_t bufA[DEPTH][POINTS], unsigned step, unsigned logn){
+  const unsigned depth = 1 << ((2 * logn) - LOGPOINTS);
+
+  unsigned row = step & (depth - 1);
+  unsigned rot = (row >> (logn - LOGPOINTS)) & (POINTS - 1);
+
+  #pragma unroll POINTS
+  for(unsigned i = 0; i < POINTS; i++){
+    bufA[row][i] = data[((i + POINTS) - rot) & (POINTS -1)];
+  }
+}
@@ -4,27 +4,26 @@
 * This file performs the transpose of 2d square matrix based on the diagonal 
 * transposition algorithm. 
 * Inputs to transposition and outputs from transposition are in normal order as * required by the FFT kernels.
+* src and dest may be the same buffer, a matrix is fetched whole before its
+* transpose is stored over it.
 */
 
 #include "mtrans_config.h"
 #include "diagonal_opt.cl" 
+#include "size.cl"
 
 #pragma OPENCL EXTENSION cl_intel_channels : enable
-channel float2 chaninTranspose[POINTS] __attribute__((depth(POINTS)));
-channel float2 chanoutTranspose[POINTS] __attribute__((depth(POINTS)));
+channel elem_t chaninTranspose[POINTS] __attribute__((depth(POINTS)));
+channel elem_t chanoutTranspose[POINTS] __attribute__((depth(POINTS)));
 
-kernel void fetch(global const volatile float2 * restrict src, int batch) {
+kernel void fetch(global const volatile elem_t * restrict src, int batch) {
 
-  for(unsigned i = 0; i < (batch * N * (N / 8)); i++){
+  for(unsigned i = 0; i < (batch * DEPTH); i++){
 
-    write_channel_intel(chaninTranspose[0], src[(i * 8) + 0]);
-    write_channel_intel(chaninTranspose[1], src[(i * 8) + 1]);
-    write_channel_intel(chaninTranspose[2], src[(i * 8) + 2]);
-    write_channel_intel(chaninTranspose[3], src[(i * 8) + 3]);
-    write_channel_intel(chaninTranspose[4], src[(i * 8) + 4]);
-    write_channel_intel(chaninTranspose[5], src[(i * 8) + 5]);
-    write_channel_intel(chaninTranspose[6], src[(i * 8) + 6]);
-    write_channel_intel(chaninTranspose[7], src[(i * 8) + 7]);
+    #pragma unroll POINTS
+    for(unsigned j = 0; j < POINTS; j++){
+      write_channel_intel(chaninTranspose[j], src[(i * POINTS) + j]);
+    }
   }
 }
 
@@ -32,25 +31,23 @@ __attribute__((max_global_work_dim(0)))
 kernel void transpose(int batch) {
   bool is_bufA = false;
 
-  float2 bufA[2][DEPTH][POINTS];
+  elem_t bufA[2][DEPTH][POINTS];
 
   for(unsigned step = 0; step < ((batch * DEPTH) + DEPTH); step++){
 
-    float2 data[POINTS];
-    float2x8 data_out;
+    elem_t data[POINTS];
+    elemP_t data_out;
 
     if (step < (batch * DEPTH) ) {
-      data[0] = read_channel_intel(chaninTranspose[0]);
-      data[1] = read_channel_intel(chaninTranspose[1]);
-      data[2] = read_channel_intel(chaninTranspose[2]);
-      data[3] = read_channel_intel(chaninTranspose[3]);
-      data[4] = read_channel_intel(chaninTranspose[4]);
-      data[5] = read_channel_intel(chaninTranspose[5]);
-      data[6] = read_channel_intel(chaninTranspose[6]);
-      data[7] = read_channel_intel(chaninTranspose[7]);
+      #pragma unroll POINTS
+      for(unsigned j = 0; j < POINTS; j++){
+        data[j] = read_channel_intel(chaninTranspose[j]);
+      }
     } else {
-      data[0] = data[1] = data[2] = data[3] = 
-                data[4] = data[5] = data[6] = data[7] = 0;
+      #pragma unroll POINTS
+      for(unsigned j = 0; j < POINTS; j++){
+        data[j] = 0;
+      }
     }
 
     is_bufA = ((step & (DEPTH - 1)) == 0) ? !is_bufA : is_bufA;
@@ -60,30 +57,23 @@ kernel void transpose(int batch) {
     writeBuf(data, is_bufA ? bufA[0] : bufA[1], step);
 
     if (step >= DEPTH) {
-      write_channel_intel(chanoutTranspose[0], data_out.i0);
-      write_channel_intel(chanoutTranspose[1], data_out.i1);
-      write_channel_intel(chanoutTranspose[2], data_out.i2);
-      write_channel_intel(chanoutTranspose[3], data_out.i3);
-      write_channel_intel(chanoutTranspose[4], data_out.i4);
-      write_channel_intel(chanoutTranspose[5], data_out.i5);
-      write_channel_intel(chanoutTranspose[6], data_out.i6);
-      write_channel_intel(chanoutTranspose[7], data_out.i7);
+      #pragma unroll POINTS
+      for(unsigned j = 0; j < POINTS; j++){
+        write_channel_intel(chanoutTranspose[j], data_out.i[j]);
+      }
     }
   }
 
 }
 
 __attribute__((max_global_work_dim(0)))
-kernel void store(global float2 * restrict dest, int batch) {
-
-  for(unsigned i = 0; i < (batch * N * (N / 8)); i++){
-    dest[(i * 8) + 0] = read_channel_intel(chanoutTranspose[0]);
-    dest[(i * 8) + 1] = read_channel_intel(chanoutTranspose[1]);
-    dest[(i * 8) + 2] = read_channel_intel(chanoutTranspose[2]);
-    dest[(i * 8) + 3] = read_channel_intel(chanoutTranspose[3]);
-    dest[(i * 8) + 4] = read_channel_intel(chanoutTranspose[4]);
-    dest[(i * 8) + 5] = read_channel_intel(chanoutTranspose[5]);
-    dest[(i * 8) + 6] = read_channel_intel(chanoutTranspose[6]);
-    dest[(i * 8) + 7] = read_channel_intel(chanoutTranspose[7]);
+kernel void store(global elem_t * restrict dest, int batch) {
+
+  for(unsigned i = 0; i < (batch * DEPTH); i++){
+
+    #pragma unroll POINTS
+    for(unsigned j = 0; j < POINTS; j++){
+      dest[(i * POINTS) + j] = read_channel_intel(chanoutTranspose[j]);
+    }
   }
 }
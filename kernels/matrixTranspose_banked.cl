@@ -0,0 +1,215 @@
+// Author: Arjun Ramaswami
+
+/*
+* Diagonal transposition as in matrixTranspose.cl replicated into a pipeline
+* per DDR bank. Kernels of pipeline b are fetch<b>, transpose<b> and store<b>
+* with their own channels, the host places the buffers of pipeline b in bank
+* b and splits the batch between the pipelines. matrixTranspose_repl.cl sets
+* PIPELINES to build REPL pipelines spread over the banks instead.
+*/
+
+#include "mtrans_config.h"
+#include "diagonal_opt.cl" 
+#include "size.cl"
+
+#ifndef PIPELINES
+#define PIPELINES BANKS
+#endif
+
+#pragma OPENCL EXTENSION cl_intel_channels : enable
+channel elem_t chaninTranspose[PIPELINES][POINTS] __attribute__((depth(POINTS)));
+channel elem_t chanoutTranspose[PIPELINES][POINTS] __attribute__((depth(POINTS)));
+
+// bank is a constant of every kernel, resolving the channels at compile time
+void fetch_bank(global const volatile elem_t * restrict src, int batch, const unsigned bank){
+
+  for(unsigned i = 0; i < (batch * DEPTH); i++){
+
+    #pragma unroll POINTS
+    for(unsigned j = 0; j < POINTS; j++){
+      write_channel_intel(chaninTranspose[bank][j], src[(i * POINTS) + j]);
+    }
+  }
+}
+
+void transpose_bank(int batch, const unsigned bank){
+  bool is_bufA = false;
+
+  elem_t bufA[2][DEPTH][POINTS];
+
+  for(unsigned step = 0; step < ((batch * DEPTH) + DEPTH); step++){
+
+    elem_t data[POINTS];
+    elemP_t data_out;
+
+    if (step < (batch * DEPTH) ) {
+      #pragma unroll POINTS
+      for(unsigned j = 0; j < POINTS; j++){
+        data[j] = read_channel_intel(chaninTranspose[bank][j]);
+      }
+    } else {
+      #pragma unroll POINTS
+      for(unsigned j = 0; j < POINTS; j++){
+        data[j] = 0;
+      }
+    }
+
+    is_bufA = ((step & (DEPTH - 1)) == 0) ? !is_bufA : is_bufA;
+
+    data_out = readBuf(is_bufA ? bufA[1] : bufA[0], step);
+
+    writeBuf(data, is_bufA ? bufA[0] : bufA[1], step);
+
+    if (step >= DEPTH) {
+      #pragma unroll POINTS
+      for(unsigned j = 0; j < POINTS; j++){
+        write_channel_intel(chanoutTranspose[bank][j], data_out.i[j]);
+      }
+    }
+  }
+}
+
+void store_bank(global elem_t * restrict dest, int batch, const unsigned bank){
+
+  for(unsigned i = 0; i < (batch * DEPTH); i++){
+
+    #pragma unroll POINTS
+    for(unsigned j = 0; j < POINTS; j++){
+      dest[(i * POINTS) + j] = read_channel_intel(chanoutTranspose[bank][j]);
+    }
+  }
+}
+
+__attribute__((max_global_work_dim(0)))
+kernel void fetch0(global const volatile elem_t * restrict src, int batch) {
+  fetch_bank(src, batch, 0);
+}
+
+__attribute__((max_global_work_dim(0)))
+kernel void transpose0(int batch) {
+  transpose_bank(batch, 0);
+}
+
+__attribute__((max_global_work_dim(0)))
+kernel void store0(global elem_t * restrict dest, int batch) {
+  store_bank(dest, batch, 0);
+}
+
+#if PIPELINES > 1
+__attribute__((max_global_work_dim(0)))
+kernel void fetch1(global const volatile elem_t * restrict src, int batch) {
+  fetch_bank(src, batch, 1);
+}
+
+__attribute__((max_global_work_dim(0)))
+kernel void transpose1(int batch) {
+  transpose_bank(batch, 1);
+}
+
+__attribute__((max_global_work_dim(0)))
+kernel void store1(global elem_t * restrict dest, int batch) {
+  store_bank(dest, batch, 1);
+}
+#endif
+
+#if PIPELINES > 2
+__attribute__((max_global_work_dim(0)))
+kernel void fetch2(global const volatile elem_t * restrict src, int batch) {
+  fetch_bank(src, batch, 2);
+}
+
+__attribute__((max_global_work_dim(0)))
+kernel void transpose2(int batch) {
+  transpose_bank(batch, 2);
+}
+
+__attribute__((max_global_work_dim(0)))
+kernel void store2(global elem_t * restrict dest, int batch) {
+  store_bank(dest, batch, 2);
+}
+#endif
+
+#if PIPELINES > 3
+__attribute__((max_global_work_dim(0)))
+kernel void fetch3(global const volatile elem_t * restrict src, int batch) {
+  fetch_bank(src, batch, 3);
+}
+
+__attribute__((max_global_work_dim(0)))
+kernel void transpose3(int batch) {
+  transpose_bank(batch, 3);
+}
+
+__attribute__((max_global_work_dim(0)))
+kernel void store3(global elem_t * restrict dest, int batch) {
+  store_bank(dest, batch, 3);
+}
+#endif
+
+#if PIPELINES > 4
+__attribute__((max_global_work_dim(0)))
+kernel void fetch4(global const volatile elem_t * restrict src, int batch) {
+  fetch_bank(src, batch, 4);
+}
+
+__attribute__((max_global_work_dim(0)))
+kernel void transpose4(int batch) {
+  transpose_bank(batch, 4);
+}
+
+__attribute__((max_global_work_dim(0)))
+kernel void store4(global elem_t * restrict dest, int batch) {
+  store_bank(dest, batch, 4);
+}
+#endif
+
+#if PIPELINES > 5
+__attribute__((max_global_work_dim(0)))
+kernel void fetch5(global const volatile elem_t * restrict src, int batch) {
+  fetch_bank(src, batch, 5);
+}
+
+__attribute__((max_global_work_dim(0)))
+kernel void transpose5(int batch) {
+  transpose_bank(batch, 5);
+}
+
+__attribute__((max_global_work_dim(0)))
+kernel void store5(global elem_t * restrict dest, int batch) {
+  store_bank(dest, batch, 5);
+}
+#endif
+
+#if PIPELINES > 6
+__attribute__((max_global_work_dim(0)))
+kernel void fetch6(global const volatile elem_t * restrict src, int batch) {
+  fetch_bank(src, batch, 6);
+}
+
+__attribute__((max_global_work_dim(0)))
+kernel void transpose6(int batch) {
+  transpose_bank(batch, 6);
+}
+
+__attribute__((max_global_work_dim(0)))
+kernel void store6(global elem_t * restrict dest, int batch) {
+  store_bank(dest, batch, 6);
+}
+#endif
+
+#if PIPELINES > 7
+__attribute__((max_global_work_dim(0)))
+kernel void fetch7(global const volatile elem_t * restrict src, int batch) {
+  fetch_bank(src, batch, 7);
+}
+
+__attribute__((max_global_work_dim(0)))
+kernel void transpose7(int batch) {
+  transpose_bank(batch, 7);
+}
+
+__attribute__((max_global_work_dim(0)))
+kernel void store7(global elem_t * restrict dest, int batch) {
+  store_bank(dest, batch, 7);
+}
+#endif
@@ -0,0 +1,126 @@
+// Authors: Tobias Kenter, Arjun Ramaswami
+
+/*
+* This file performs the transpose of 2d square matrices as matrixTranspose.cl
+* with kernels launched once and kept running, so that a transposition does
+* not pay the launch of every kernel. fetch and store are launched once by the
+* host and poll a doorbell in global memory for work descriptors, the
+* transpose is an autorun kernel started with the FPGA. fetch forwards every
+* descriptor to the transpose and to store, which writes the sequence number
+* of the descriptor to done once its matrices are stored. A negative sequence
+* number stops fetch and store.
+*/
+
+#include "mtrans_config.h"
+#include "diagonal_opt.cl"
+#include "size.cl"
+
+// Words of the doorbell, a descriptor is posted by writing its sequence
+// number after the other words
+#define DOORBELL_SEQ 0     // sequence number, negative to stop
+#define DOORBELL_OFFSET 1  // first matrix of the batch in src and dest
+#define DOORBELL_BATCH 2   // matrices of the batch
+
+#pragma OPENCL EXTENSION cl_intel_channels : enable
+channel elem_t chaninTranspose[POINTS] __attribute__((depth(POINTS)));
+channel elem_t chanoutTranspose[POINTS] __attribute__((depth(POINTS)));
+channel int chanbatchTranspose __attribute__((depth(1)));
+channel int3 chandescStore __attribute__((depth(1)));  // seq, offset, batch
+
+// Marks the bitstream as persistent, read by the host on initialization
+__attribute__((max_global_work_dim(0)))
+kernel void persistent(global int * restrict persistent) {
+  persistent[0] = 1;
+}
+
+__attribute__((max_global_work_dim(0)))
+kernel void fetch(global const volatile elem_t * restrict src, global volatile int * restrict doorbell) {
+  int seq = 0;
+
+  while(seq >= 0){
+    int posted = doorbell[DOORBELL_SEQ];
+    if(posted == seq)
+      continue;
+
+    int3 desc = (int3)(posted, doorbell[DOORBELL_OFFSET], doorbell[DOORBELL_BATCH]);
+    seq = posted;
+    write_channel_intel(chandescStore, desc);
+    if(seq < 0)
+      break;
+    write_channel_intel(chanbatchTranspose, desc.z);
+
+    const unsigned base = desc.y * DEPTH * POINTS;
+    for(unsigned i = 0; i < (desc.z * DEPTH); i++){
+
+      #pragma unroll POINTS
+      for(unsigned j = 0; j < POINTS; j++){
+        write_channel_intel(chaninTranspose[j], src[base + (i * POINTS) + j]);
+      }
+    }
+  }
+}
+
+__attribute__((autorun))
+__attribute__((max_global_work_dim(0)))
+kernel void transpose() {
+  elem_t bufA[2][DEPTH][POINTS];
+
+  while(1){
+    int batch = read_channel_intel(chanbatchTranspose);
+    bool is_bufA = false;
+
+    for(unsigned step = 0; step < ((batch * DEPTH) + DEPTH); step++){
+
+      elem_t data[POINTS];
+      elemP_t data_out;
+
+      if (step < (batch * DEPTH) ) {
+        #pragma unroll POINTS
+        for(unsigned j = 0; j < POINTS; j++){
+          data[j] = read_channel_intel(chaninTranspose[j]);
+        }
+      } else {
+        #pragma unroll POINTS
+        for(unsigned j = 0; j < POINTS; j++){
+          data[j] = 0;
+        }
+      }
+
+      is_bufA = ((step & (DEPTH - 1)) == 0) ? !is_bufA : is_bufA;
+
+      data_out = readBuf(is_bufA ? bufA[1] : bufA[0], step);
+
+      writeBuf(data, is_bufA ? bufA[0] : bufA[1], step);
+
+      if (step >= DEPTH) {
+        #pragma unroll POINTS
+        for(unsigned j = 0; j < POINTS; j++){
+          write_channel_intel(chanoutTranspose[j], data_out.i[j]);
+        }
+      }
+    }
+  }
+}
+
+__attribute__((max_global_work_dim(0)))
+kernel void store(global elem_t * restrict dest, global volatile int * restrict done) {
+  int seq = 0;
+
+  while(seq >= 0){
+    int3 desc = read_channel_intel(chandescStore);
+    seq = desc.x;
+
+    const unsigned base = desc.y * DEPTH * POINTS;
+    for(unsigned i = 0; (seq >= 0) && (i < (desc.z * DEPTH)); i++){
+
+      #pragma unroll POINTS
+      for(unsigned j = 0; j < POINTS; j++){
+        dest[base + (i * POINTS) + j] = read_channel_intel(chanoutTranspose[j]);
+      }
+    }
+
+    // matrices visible to the host before it sees the sequence number
+    mem_fence(CLK_GLOBAL_MEM_FENCE);
+    done[0] = seq;
+  }
+}
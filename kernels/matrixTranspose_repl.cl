@@ -0,0 +1,20 @@
+// Author: Arjun Ramaswami
+
+/*
+* Diagonal transposition as in matrixTranspose.cl replicated into REPL
+* independent pipelines, e.g. to fill the BRAM and bandwidth a single pipeline
+* leaves unused for small N. Pipelines are those of matrixTranspose_banked.cl,
+* the host spreads their buffers over the BANKS DDR banks round robin and
+* splits the batch between them.
+*/
+
+#include "mtrans_config.h"
+
+#define PIPELINES REPL
+#include "matrixTranspose_banked.cl"
+
+// DDR banks the pipelines are spread over, read by the host on initialization
+__attribute__((max_global_work_dim(0)))
+kernel void banks(global int * restrict banks) {
+  banks[0] = BANKS;
+}
@@ -0,0 +1,87 @@
+// Authors: Tobias Kenter, Arjun Ramaswami
+
+/*
+* This file performs the transpose of 2d square matrices as matrixTranspose.cl
+* for any length 2^logn given at runtime, from POINTS up to N of the
+* configuration, so that a single bitstream transposes matrices of mixed
+* sizes without reprogramming the FPGA. The transpose buffer is sized for N.
+*/
+
+#include "mtrans_config.h"
+#include "diagonal_runtime.cl"
+
+#pragma OPENCL EXTENSION cl_intel_channels : enable
+channel elem_t chaninTranspose[POINTS] __attribute__((depth(POINTS)));
+channel elem_t chanoutTranspose[POINTS] __attribute__((depth(POINTS)));
+
+// sizes as in size.cl, the log of the largest length
+__attribute__((max_global_work_dim(0)))
+kernel void max_size(global int * restrict size) {
+  size[0] = LOGN;
+  size[1] = LOGPOINTS;
+}
+
+kernel void fetch(global const volatile elem_t * restrict src, int batch, int logn) {
+  const unsigned depth = 1 << ((2 * logn) - LOGPOINTS);
+
+  for(unsigned i = 0; i < (batch * depth); i++){
+
+    #pragma unroll POINTS
+    for(unsigned j = 0; j < POINTS; j++){
+      write_channel_intel(chaninTranspose[j], src[(i * POINTS) + j]);
+    }
+  }
+}
+
+__attribute__((max_global_work_dim(0)))
+kernel void transpose(int batch, int logn) {
+  const unsigned depth = 1 << ((2 * logn) - LOGPOINTS);
+  bool is_bufA = false;
+
+  elem_t bufA[2][DEPTH][POINTS];
+
+  for(unsigned step = 0; step < ((batch * depth) + depth); step++){
+
+    elem_t data[POINTS];
+    elemP_t data_out;
+
+    if (step < (batch * depth) ) {
+      #pragma unroll POINTS
+      for(unsigned j = 0; j < POINTS; j++){
+        data[j] = read_channel_intel(chaninTranspose[j]);
+      }
+    } else {
+      #pragma unroll POINTS
+      for(unsigned j = 0; j < POINTS; j++){
+        data[j] = 0;
+      }
+    }
+
+    is_bufA = ((step & (depth - 1)) == 0) ? !is_bufA : is_bufA;
+
+    data_out = readBuf(is_bufA ? bufA[1] : bufA[0], step, logn);
+
+    writeBuf(data, is_bufA ? bufA[0] : bufA[1], step, logn);
+
+    if (step >= depth) {
+      #pragma unroll POINTS
+      for(unsigned j = 0; j < POINTS; j++){
+        write_channel_intel(chanoutTranspose[j], data_out.i[j]);
+      }
+    }
+  }
+
+}
+
+__attribute__((max_global_work_dim(0)))
+kernel void store(global elem_t * restrict dest, int batch, int logn) {
+  const unsigned depth = 1 << ((2 * logn) - LOGPOINTS);
+
+  for(unsigned i = 0; i < (batch * depth); i++){
+
+    #pragma unroll POINTS
+    for(unsigned j = 0; j < POINTS; j++){
+      dest[(i * POINTS) + j] = read_channel_intel(chanoutTranspose[j]);
+    }
+  }
+}
@@ -1,21 +1,13 @@
 //  Authors: Tobias Kenter, Arjun Ramaswami
 
-#ifndef LOGN
-#define LOGN 6
-#endif
+#include "mtrans_config.h"
+#include "size.cl"
 
-// Macros for the 8 point 1d FFT
-#define LOGPOINTS 3
-#define POINTS (1 << LOGPOINTS)
-
-// Log of the number of replications of the pipeline
-#define LOGREPL 2            // 4 replications
-#define REPL (1 << LOGREPL)  // 4 replications
-#define UNROLL_FACTOR 8
+#define UNROLL_FACTOR POINTS
 
 #pragma OPENCL EXTENSION cl_intel_channels : enable
-channel float2 chaninTranspose[8] __attribute__((depth(8)));
-channel float2 chanoutTranspose[8] __attribute__((depth(8)));
+channel elem_t chaninTranspose[POINTS] __attribute__((depth(POINTS)));
+channel elem_t chanoutTranspose[POINTS] __attribute__((depth(POINTS)));
 
 // --- CODE -------------------------------------------------------------------
 int bit_reversed(int x, int bits) {
@@ -31,46 +23,35 @@ int bit_reversed(int x, int bits) {
 
 
 __attribute__((reqd_work_group_size((1 << LOGN), 1, 1)))
-kernel void fetch(global const volatile float2 * restrict src) {
-  const int N = ( 1 << LOGN);
-  local float2 buf[8 * N];
+kernel void fetch(global const volatile elem_t * restrict src) {
+  local elem_t buf[POINTS * N];
 
   unsigned where_global = get_global_id(0) << LOGPOINTS;
   unsigned where_local= get_local_id(0) << LOGPOINTS;
 
-  buf[(where_local & ((1 << (LOGN + LOGPOINTS)) - 1))] = src[where_global];
-  buf[(where_local & ((1 << (LOGN + LOGPOINTS)) - 1)) + 1] = src[where_global + 1];
-  buf[(where_local & ((1 << (LOGN + LOGPOINTS)) - 1)) + 2] = src[where_global + 2];
-  buf[(where_local & ((1 << (LOGN + LOGPOINTS)) - 1)) + 3] = src[where_global + 3];
-  buf[(where_local & ((1 << (LOGN + LOGPOINTS)) - 1)) + 4] = src[where_global + 4];
-  buf[(where_local & ((1 << (LOGN + LOGPOINTS)) - 1)) + 5] = src[where_global + 5];
-  buf[(where_local & ((1 << (LOGN + LOGPOINTS)) - 1)) + 6] = src[where_global + 6];
-  buf[(where_local & ((1 << (LOGN + LOGPOINTS)) - 1)) + 7] = src[where_global + 7];
+  #pragma unroll POINTS
+  for(unsigned j = 0; j < POINTS; j++){
+    buf[(where_local & ((1 << (LOGN + LOGPOINTS)) - 1)) + j] = src[where_global + j];
+  }
 
   barrier(CLK_LOCAL_MEM_FENCE);
 
   unsigned where_buf = get_local_id(0) << LOGPOINTS;
 
-  // Stream fetched data over 8 channels to the FFT engine
-  write_channel_intel(chaninTranspose[0], buf[where_buf + 0]);
-  write_channel_intel(chaninTranspose[1], buf[where_buf + 1]);
-  write_channel_intel(chaninTranspose[2], buf[where_buf + 2]);
-  write_channel_intel(chaninTranspose[3], buf[where_buf + 3]);
-  write_channel_intel(chaninTranspose[4], buf[where_buf + 4]);
-  write_channel_intel(chaninTranspose[5], buf[where_buf + 5]);
-  write_channel_intel(chaninTranspose[6], buf[where_buf + 6]);
-  write_channel_intel(chaninTranspose[7], buf[where_buf + 7]);
+  // Stream fetched data over POINTS channels to the FFT engine
+  #pragma unroll POINTS
+  for(unsigned j = 0; j < POINTS; j++){
+    write_channel_intel(chaninTranspose[j], buf[where_buf + j]);
+  }
 }
 
 // Transposes fetched data; stores them to global memory
 __attribute__((reqd_work_group_size((1 << (LOGN + LOGN - LOGPOINTS)), 1, 1)) )
 kernel void transpose(int iter) {
-  const unsigned N = (1 << LOGN);
 
   // TODO: 8 bytes for float2 but 16 for double2
   //#define DEPTH = (N*N/POINTS)
-  const unsigned DEPTH = (1 << (LOGN + LOGN - LOGPOINTS));
-  local float2 buf1[DEPTH][POINTS];
+  local elem_t buf1[DEPTH][POINTS];
   unsigned lid = get_local_id(0);
 
   //        layout following modification of earlier MaxJ design: rotate at new input row
@@ -110,7 +91,7 @@ kernel void transpose(int iter) {
 
   unsigned rot = (lid >> (LOGN - LOGPOINTS)) & (POINTS-1); //0...POINTS-1
 
-  float2 rotate_in[POINTS];
+  elem_t rotate_in[POINTS];
   #pragma unroll
   for(unsigned i = 0; i < POINTS; i++){
     rotate_in[i] = read_channel_intel(chaninTranspose[i]);
@@ -132,7 +113,7 @@ kernel void transpose(int iter) {
     }
   }*/
 
-  float2 rotate_out[POINTS];
+  elem_t rotate_out[POINTS];
   unsigned row_base = (lid & (N/POINTS-1)) << LOGN; // 0, N, 2N, ...
   unsigned row_offset = lid >> LOGN; //0... N/POINTS
   #pragma unroll
@@ -152,8 +133,8 @@ kernel void transpose(int iter) {
 
 /*
   #pragma unroll
-  for(unsigned i = 0; i < 8; i++){
-    unsigned loc_id = (get_local_id(0) * 8) + i;
+  for(unsigned i = 0; i < POINTS; i++){
+    unsigned loc_id = (get_local_id(0) * POINTS) + i;
     unsigned order = ((loc_id >> LOGN) + loc_id) & ((1 << LOGN) - 1);
     //unsigned col = loc_id & ((1 << LOGN) - 1);
     write_channel_intel(chanoutTranspose[i], tmp[order]);
@@ -169,38 +150,32 @@ kernel void transpose(int iter) {
   }
 
   const unsigned buf_len = (N * N * 2) - 16;
-  float2 transpose_buf[buf_len];
-  unsigned exit_condition = 2 * (buf_len / 8);
+  elem_t transpose_buf[buf_len];
+  unsigned exit_condition = 2 * (buf_len / POINTS);
 
   for (unsigned step = 0; step < iter * exit_condition; step++) {
-    float28 data;
+    elemP_t data;
 
     // push data to register
-    if( step < ( N * N / 8)){
-      data.i0 =  read_channel_intel(chaninTranspose[0]);
-      data.i1 =  read_channel_intel(chaninTranspose[1]);
-      data.i2 =  read_channel_intel(chaninTranspose[2]);
-      data.i3 =  read_channel_intel(chaninTranspose[3]);
-      data.i4 =  read_channel_intel(chaninTranspose[4]);
-      data.i5 =  read_channel_intel(chaninTranspose[5]);
-      data.i6 =  read_channel_intel(chaninTranspose[6]);
-      data.i7 =  read_channel_intel(chaninTranspose[7]);
+    if( step < ( N * N / POINTS)){
+      #pragma unroll POINTS
+      for(unsigned j = 0; j < POINTS; j++){
+        data.i[j] = read_channel_intel(chaninTranspose[j]);
+      }
     } else {
-      data.i0 = data.i1 = data.i2 = data.i3 =
-                data.i4 = data.i5 = data.i6 = data.i7 = 0;
+      #pragma unroll POINTS
+      for(unsigned j = 0; j < POINTS; j++){
+        data.i[j] = 0;
+      }
     }
 
     data = transpose_step(data, step, transpose_buf, buf_len, LOGN);
 
-    if (step >= ((buf_len / 8) - 1)){
-      write_channel_intel(chanoutTranspose[0], data.i0);
-      write_channel_intel(chanoutTranspose[1], data.i1);
-      write_channel_intel(chanoutTranspose[2], data.i2);
-      write_channel_intel(chanoutTranspose[3], data.i3);
-      write_channel_intel(chanoutTranspose[4], data.i4);
-      write_channel_intel(chanoutTranspose[5], data.i5);
-      write_channel_intel(chanoutTranspose[6], data.i6);
-      write_channel_intel(chanoutTranspose[7], data.i7);
+    if (step >= ((buf_len / POINTS) - 1)){
+      #pragma unroll POINTS
+      for(unsigned j = 0; j < POINTS; j++){
+        write_channel_intel(chanoutTranspose[j], data.i[j]);
+      }
     }
   }
 
@@ -208,32 +183,23 @@ kernel void transpose(int iter) {
 */
 
 __attribute__((reqd_work_group_size((1 << LOGN), 1, 1)))
-kernel void store(global float2 * restrict dest) {
-  const int N = (1 << LOGN);
-  local float2 buf[8 * N];
+kernel void store(global elem_t * restrict dest) {
+  local elem_t buf[POINTS * N];
 
   unsigned where_buf = get_local_id(0) << LOGPOINTS;
 
-  buf[(where_buf + 0) & ((1 << (LOGN + LOGPOINTS)) - 1)] = read_channel_intel(chanoutTranspose[0]);
-  buf[(where_buf + 1) & ((1 << (LOGN + LOGPOINTS)) - 1)] = read_channel_intel(chanoutTranspose[1]);
-  buf[(where_buf + 2) & ((1 << (LOGN + LOGPOINTS)) - 1)] = read_channel_intel(chanoutTranspose[2]);
-  buf[(where_buf + 3) & ((1 << (LOGN + LOGPOINTS)) - 1)] = read_channel_intel(chanoutTranspose[3]);
-  buf[(where_buf + 4) & ((1 << (LOGN + LOGPOINTS)) - 1)] = read_channel_intel(chanoutTranspose[4]);
-  buf[(where_buf + 5) & ((1 << (LOGN + LOGPOINTS)) - 1)] = read_channel_intel(chanoutTranspose[5]);
-  buf[(where_buf + 6) & ((1 << (LOGN + LOGPOINTS)) - 1)] = read_channel_intel(chanoutTranspose[6]);
-  buf[(where_buf + 7) & ((1 << (LOGN + LOGPOINTS)) - 1)] = read_channel_intel(chanoutTranspose[7]);
+  #pragma unroll POINTS
+  for(unsigned j = 0; j < POINTS; j++){
+    buf[(where_buf + j) & ((1 << (LOGN + LOGPOINTS)) - 1)] = read_channel_intel(chanoutTranspose[j]);
+  }
 
   barrier(CLK_LOCAL_MEM_FENCE);
 
   unsigned where_global = get_global_id(0) << LOGPOINTS;
   unsigned where = get_local_id(0) << LOGPOINTS;
 
-  dest[where_global]     = buf[where + 0];
-  dest[where_global + 1] = buf[where + 1];
-  dest[where_global + 2] = buf[where + 2];
-  dest[where_global + 3] = buf[where + 3];
-  dest[where_global + 4] = buf[where + 4];
-  dest[where_global + 5] = buf[where + 5];
-  dest[where_global + 6] = buf[where + 6];
-  dest[where_global + 7] = buf[where + 7];
+  #pragma unroll POINTS
+  for(unsigned j = 0; j < POINTS; j++){
+    dest[where_global + j] = buf[where + j];
+  }
 }
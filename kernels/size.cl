@@ -0,0 +1,12 @@
+// Author: Arjun Ramaswami
+
+/*
+* Sizes of the bitstream, read by the host on initialization to check the
+* sizes of plans and to launch the kernels with the points of a cycle.
+*/
+
+__attribute__((max_global_work_dim(0)))
+kernel void size(global int * restrict size) {
+  size[0] = LOGN;
+  size[1] = LOGPOINTS;
+}